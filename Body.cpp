@@ -16,11 +16,16 @@ void Body::Update(const float dt_sec)
 	// Texternal = 0 because it was applied in the collision response function
 	// T = Ia = w x I * w
 	// a = I^-1 (w x I * w)
-	Mat3 orientationMat = orientation.ToMat3();
-	Mat3 inertiaTensor = orientationMat	* shape->InertiaTensor() * orientationMat.Transpose();
-	Vec3 alpha = inertiaTensor.Inverse() * (angularVelocity.Cross(inertiaTensor * angularVelocity));
+	// With the same inertia around every axis, I * w is parallel to w and the torque vanishes
+	if (!shape->IsSpherical())
+	{
+		Mat3 orientationMat = orientation.ToMat3();
+		Mat3 inertiaTensor = orientationMat	* shape->GetInertiaTensor() * orientationMat.Transpose();
+		Mat3 inverseInertiaTensor = orientationMat * shape->GetInverseInertiaTensor() * orientationMat.Transpose();
+		Vec3 alpha = inverseInertiaTensor * (angularVelocity.Cross(inertiaTensor * angularVelocity));
 
-	angularVelocity += alpha * dt_sec;
+		angularVelocity += alpha * dt_sec;
+	}
 
 	// Update orientation
 	Vec3 dAngle = angularVelocity * dt_sec;	//Rcupr angle
@@ -32,6 +37,29 @@ void Body::Update(const float dt_sec)
 	position = positionCM + dq.RotatePoint(CMToPositon);
 }
 
+/// <summary>
+/// Dplace le body avec ses pseudo vitesses de correction de pntration, puis les annule
+/// </summary>
+void Body::ApplyPseudoVelocity(const float dt_sec)
+{
+	const Vec3 positionCM = GetCenterOfMassWorldSpace();
+	Vec3 CMToPosition = position - positionCM;
+
+	const Vec3 dAngle = pseudoAngularVelocity * dt_sec;
+	const float angle = dAngle.GetMagnitude();
+	if (angle > 0.0f)
+	{
+		const Quat dq = Quat(dAngle, angle);
+		orientation = dq * orientation;
+		orientation.Normalize();
+		CMToPosition = dq.RotatePoint(CMToPosition);
+	}
+	position = positionCM + pseudoLinearVelocity * dt_sec + CMToPosition;
+
+	pseudoLinearVelocity.Zero();
+	pseudoAngularVelocity.Zero();
+}
+
 Vec3 Body::GetCenterOfMassWorldSpace() const
 {
 	const Vec3 centerOfMass = shape->GetCenterOfMass();
@@ -46,16 +74,14 @@ Vec3 Body::GetCenterOfMassBodySpace() const
 
 Mat3 Body::GetInverseInertiaTensorBodySpace() const
 {
-	Mat3 inertiaTensor = shape->InertiaTensor();	//Get le tensor
-	Mat3 inverseInertiaTensor = inertiaTensor.Inverse() * inverseMass;	//On l'inverse et le multiplie avec la masse pour avoir son intertie tensor
+	Mat3 inverseInertiaTensor = shape->GetInverseInertiaTensor() * inverseMass;	//Inverse du tensor, calcule une fois par shape, multiplie par la masse pour avoir son intertie tensor
 
 	return inverseInertiaTensor;
 }
 
 Mat3 Body::GetInverseInertiaTensorWorldSpace() const
 {
-	Mat3 inertiaTensor = shape->InertiaTensor();
-	Mat3 inverseInertiaTensor = inertiaTensor.Inverse() * inverseMass;
+	Mat3 inverseInertiaTensor = shape->GetInverseInertiaTensor() * inverseMass;
 	Mat3 orient = orientation.ToMat3();
 	inverseInertiaTensor = orient * inverseInertiaTensor * orient.Transpose();
 
@@ -87,6 +113,16 @@ Vec3 Body::BodySpaceToWorldSpace(const Vec3& bodyPoint)
 	return worldSpace;
 }
 
+/// <summary>
+/// Endort le corps: il ne bouge plus jusqu' ce qu'un impulse ou un contact avec un corps veill le rveille
+/// </summary>
+void Body::Sleep()
+{
+	isAwake = false;
+	linearVelocity.Zero();
+	angularVelocity.Zero();
+}
+
 /// <summary>
 /// Applique un impulse  un endroit prcis
 /// </summary>
@@ -107,6 +143,7 @@ void Body::ApplyImpulse(const Vec3& impulsePoint, const Vec3& impulse)
 void Body::ApplyImpulseLinear(const Vec3& impulse)
 {
 	if (inverseMass == 0.0f) return;
+	if (!isAwake) Wake();
 	// dv = J / m
 	linearVelocity += impulse * inverseMass;
 }
@@ -114,10 +151,16 @@ void Body::ApplyImpulseLinear(const Vec3& impulse)
 void Body::ApplyImpulseAngular(const Vec3& impulse)
 {
 	if (inverseMass == 0.0f) return;
+	if (!isAwake) Wake();
 	// L = I w = r x p
 	// dL = I dw = r x J
 	// dw = I^-1 * ( r x J )
 	angularVelocity += GetInverseInertiaTensorWorldSpace() * impulse;
+	ClampAngularVelocity();
+}
+
+void Body::ClampAngularVelocity()
+{
 	// Clamp angular velocity
 	// -- 30 rad per seconds, sufficient for now
 	const float maxAngularSpeed = 30.0f;
@@ -127,3 +170,11 @@ void Body::ApplyImpulseAngular(const Vec3& impulse)
 		angularVelocity *= maxAngularSpeed;
 	}
 }
+
+void Body::ApplyPseudoImpulse(const Vec3& impulsePoint, const Vec3& impulse)
+{
+	if (inverseMass == 0.0f) return;
+	const Vec3 r = impulsePoint - GetCenterOfMassWorldSpace();
+	pseudoLinearVelocity += impulse * inverseMass;
+	pseudoAngularVelocity += GetInverseInertiaTensorWorldSpace() * r.Cross(impulse);
+}
@@ -12,13 +12,28 @@ public:
 	Vec3 linearVelocity;
 	Vec3 angularVelocity;;
 
+	// Split impulse: velocities that only push penetrating bodies apart.
+	// They move the body once at the end of the step and are then cleared, they never add kinetic energy
+	Vec3 pseudoLinearVelocity;
+	Vec3 pseudoAngularVelocity;
+
 	float inverseMass;
 	float elasticity;
 	float friction;
 
 	Shape* shape;
 
+	// Resting bodies are put to sleep with their island: no gravity, no integration, no collision between sleeping bodies.
+	// Impulses wake a body, call Wake() after moving it by hand
+	bool isAwake{ true };
+	float sleepTime{ 0.0f };	// How long the body has been below the sleep velocities
+
+	void Wake() { isAwake = true; sleepTime = 0.0f; }
+	void Sleep();
+	bool IsResting() const { return inverseMass == 0.0f || !isAwake; }
+
 	void Update(const float dt_sec);
+	void ApplyPseudoVelocity(const float dt_sec);
 
 	Vec3 GetCenterOfMassWorldSpace() const;
 	Vec3 GetCenterOfMassBodySpace() const;
@@ -33,5 +48,9 @@ public:
 	void ApplyImpulse(const Vec3& impulsePoint, const Vec3& impulse);
 	void ApplyImpulseLinear(const Vec3& impulse);
 	void ApplyImpulseAngular(const Vec3& impulse);
+	void ApplyPseudoImpulse(const Vec3& impulsePoint, const Vec3& impulse);
+
+	// Solvers that write angularVelocity directly call this once they are done
+	void ClampAngularVelocity();
 };
 
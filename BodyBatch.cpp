@@ -0,0 +1,86 @@
+#include "BodyBatch.h"
+#include "FloatLanes.h"
+
+/// <summary>
+/// Un groupe de WIDTH corps, mmes tapes que Body::Update pour une shape sphrique
+/// </summary>
+static void IntegrateLanes(BodyBatch& batch, const int first)
+{
+	typedef FloatLanes F;
+	const F zero(0.0f);
+	const F one(1.0f);
+
+	const F dt = F::Load(batch.dt + first);
+
+	(F::Load(batch.positionX + first) + F::Load(batch.linearVelocityX + first) * dt).Store(batch.positionX + first);
+	(F::Load(batch.positionY + first) + F::Load(batch.linearVelocityY + first) * dt).Store(batch.positionY + first);
+	(F::Load(batch.positionZ + first) + F::Load(batch.linearVelocityZ + first) * dt).Store(batch.positionZ + first);
+
+	// Rotation of the step as a quaternion, Quat(dAngle, |dAngle|)
+	const F angleX = F::Load(batch.angularVelocityX + first) * dt;
+	const F angleY = F::Load(batch.angularVelocityY + first) * dt;
+	const F angleZ = F::Load(batch.angularVelocityZ + first) * dt;
+	const F angle = Sqrt(angleX * angleX + angleY * angleY + angleZ * angleZ);
+	F halfSine;
+	F halfCosine;
+	SinCos(F(0.5f) * angle, halfSine, halfCosine);
+	// No rotation: the axis stays null instead of 0 / 0
+	const F inverseAngle = Select(GreaterThan(angle, zero), one / angle, zero);
+	const F dqW = halfCosine;
+	const F dqX = (angleX * inverseAngle) * halfSine;
+	const F dqY = (angleY * inverseAngle) * halfSine;
+	const F dqZ = (angleZ * inverseAngle) * halfSine;
+
+	// orientation = dq * orientation, term by term like Quat::operator *
+	const F w = F::Load(batch.orientationW + first);
+	const F x = F::Load(batch.orientationX + first);
+	const F y = F::Load(batch.orientationY + first);
+	const F z = F::Load(batch.orientationZ + first);
+	F newW = (dqW * w) - (dqX * x) - (dqY * y) - (dqZ * z);
+	F newX = (dqX * w) + (dqW * x) + (dqY * z) - (dqZ * y);
+	F newY = (dqY * w) + (dqW * y) + (dqZ * x) - (dqX * z);
+	F newZ = (dqZ * w) + (dqW * z) + (dqX * y) - (dqY * x);
+
+	// Quat::Normalize, skipped for a null quaternion
+	const F magnitudeSqr = (newX * newX) + (newY * newY) + (newZ * newZ) + (newW * newW);
+	const F inverseMagnitude = Select(GreaterThan(magnitudeSqr, zero), one / Sqrt(magnitudeSqr), one);
+	(newW * inverseMagnitude).Store(batch.orientationW + first);
+	(newX * inverseMagnitude).Store(batch.orientationX + first);
+	(newY * inverseMagnitude).Store(batch.orientationY + first);
+	(newZ * inverseMagnitude).Store(batch.orientationZ + first);
+}
+
+/// <summary>
+/// Met  zro les lanes entre count et la fin du dernier registre, jamais crites par la scne
+/// </summary>
+static void ClearUnusedLanes(BodyBatch& batch)
+{
+	const int end = ((batch.count + FloatLanes::WIDTH - 1) / FloatLanes::WIDTH) * FloatLanes::WIDTH;
+	for (int i = batch.count; i < end; i++)
+	{
+		batch.positionX[i] = 0.0f;
+		batch.positionY[i] = 0.0f;
+		batch.positionZ[i] = 0.0f;
+		batch.orientationW[i] = 0.0f;
+		batch.orientationX[i] = 0.0f;
+		batch.orientationY[i] = 0.0f;
+		batch.orientationZ[i] = 0.0f;
+		batch.linearVelocityX[i] = 0.0f;
+		batch.linearVelocityY[i] = 0.0f;
+		batch.linearVelocityZ[i] = 0.0f;
+		batch.angularVelocityX[i] = 0.0f;
+		batch.angularVelocityY[i] = 0.0f;
+		batch.angularVelocityZ[i] = 0.0f;
+		batch.dt[i] = 0.0f;
+	}
+}
+
+void IntegrateBodiesBatch(BodyBatch& batch)
+{
+	// The last register of a partial batch would otherwise compute on whatever was on the stack, NaNs and denormals included
+	ClearUnusedLanes(batch);
+	for (int first = 0; first < batch.count; first += FloatLanes::WIDTH)
+	{
+		IntegrateLanes(batch, first);
+	}
+}
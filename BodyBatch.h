@@ -0,0 +1,38 @@
+#pragma once
+
+/// <summary>
+/// Moving state of spherical bodies laid out as structure of arrays, so the integration runs several bodies per SIMD register.
+/// Each body has its own time step. Lanes past count are cleared by IntegrateBodiesBatch, their results are not used.
+/// </summary>
+struct BodyBatch
+{
+	static const int MAX_BODIES = 16;
+
+	alignas(64) float positionX[MAX_BODIES];
+	alignas(64) float positionY[MAX_BODIES];
+	alignas(64) float positionZ[MAX_BODIES];
+
+	alignas(64) float orientationW[MAX_BODIES];
+	alignas(64) float orientationX[MAX_BODIES];
+	alignas(64) float orientationY[MAX_BODIES];
+	alignas(64) float orientationZ[MAX_BODIES];
+
+	alignas(64) float linearVelocityX[MAX_BODIES];
+	alignas(64) float linearVelocityY[MAX_BODIES];
+	alignas(64) float linearVelocityZ[MAX_BODIES];
+	alignas(64) float angularVelocityX[MAX_BODIES];
+	alignas(64) float angularVelocityY[MAX_BODIES];
+	alignas(64) float angularVelocityZ[MAX_BODIES];
+
+	alignas(64) float dt[MAX_BODIES];
+
+	int count;
+};
+
+/// <summary>
+/// Body::Update for a whole batch of bodies whose shape IsSpherical(): no gyroscopic term, the velocities stay as they are.
+/// Positions and orientations are written back in place. Uses AVX-512, AVX2 or SSE depending on the compiler flags,
+/// or plain scalar code when PHYSICS_NO_SIMD is defined. The sine and cosine are polynomials, so orientations
+/// differ from Body::Update by a few ulps; positions are the same
+/// </summary>
+void IntegrateBodiesBatch(BodyBatch& batch);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Broadphase.h"
 #include "code/Math/Bounds.h"
 #include "Shape.h"
@@ -5,36 +6,44 @@
 int CompareSAP(const void* a, const void* b) {
 	const PseudoBody* ea = (const PseudoBody*)a;
 	const PseudoBody* eb = (const PseudoBody*)b;
-	if (ea->value < eb->value) 
+	// Total order: equal values are sorted by body then min before max, whatever the sort algorithm
+	if (ea->value != eb->value)
 	{
-		return -1;
+		return (ea->value < eb->value) ? -1 : 1;
 	}
-	return 1;
+	if (ea->id != eb->id)
+	{
+		return (ea->id < eb->id) ? -1 : 1;
+	}
+	if (ea->ismin != eb->ismin)
+	{
+		return ea->ismin ? -1 : 1;
+	}
+	return 0;
+}
+
+bool LessSAP(const PseudoBody& a, const PseudoBody& b)
+{
+	return CompareSAP(&a, &b) < 0;
 }
 
-void SortBodiesBounds(const Body* bodies, const size_t num, PseudoBody* sortedArray, const float dt_sec)
+/// <summary>
+/// Projection of the swept bounds of a body on the sweep axis
+/// </summary>
+void ProjectBounds(const Body& body, const float dt_sec, float& minValue, float& maxValue)
 {
 	Vec3 axis = Vec3(1, 1, 1);
 	axis.Normalize();
-	for (int i = 0; i < num; i++)
-	{
-		const Body& body = bodies[i];
-		Bounds bounds =
-			body.shape->GetBounds(body.position, body.orientation);
-		// Expand the bounds by the linear velocity
-		bounds.Expand(bounds.mins + body.linearVelocity * dt_sec);
-		bounds.Expand(bounds.maxs + body.linearVelocity * dt_sec);
-		const float epsilon = 0.01f;
-		bounds.Expand(bounds.mins + Vec3(-1, -1, -1) * epsilon);
-		bounds.Expand(bounds.maxs + Vec3(1, 1, 1) * epsilon);
-		sortedArray[i * 2 + 0].id = i;
-		sortedArray[i * 2 + 0].value = axis.Dot(bounds.mins);
-		sortedArray[i * 2 + 0].ismin = true;
-		sortedArray[i * 2 + 1].id = i;
-		sortedArray[i * 2 + 1].value = axis.Dot(bounds.maxs);
-		sortedArray[i * 2 + 1].ismin = false;
-	}
-	qsort(sortedArray, num * 2, sizeof(PseudoBody), CompareSAP);
+	Bounds bounds =
+		body.shape->GetBounds(body.position, body.orientation);
+	// Expand the bounds by the linear velocity
+	bounds.Expand(bounds.mins + body.linearVelocity * dt_sec);
+	bounds.Expand(bounds.maxs + body.linearVelocity * dt_sec);
+	const float epsilon = 0.01f;
+	bounds.Expand(bounds.mins + Vec3(-1, -1, -1) * epsilon);
+	bounds.Expand(bounds.maxs + Vec3(1, 1, 1) * epsilon);
+	minValue = axis.Dot(bounds.mins);
+	maxValue = axis.Dot(bounds.maxs);
 }
 
 void BuildPairs(std::vector< CollisionPair >& collisionPairs,const PseudoBody* sortedBodies, const int num)
@@ -64,15 +73,91 @@ void BuildPairs(std::vector< CollisionPair >& collisionPairs,const PseudoBody* s
 	}
 }
 
-void SweepAndPrune1D(const Body* bodies, const size_t num, std::vector< CollisionPair >& finalPairs, const float dt_sec)
+void SweepAndPrune::AddBodies(const Body* bodies, const int num)
 {
-	PseudoBody* sortedBodies = (PseudoBody*)alloca(sizeof(PseudoBody) * num * 2);
-	SortBodiesBounds(bodies, num, sortedBodies, dt_sec);
-	BuildPairs(finalPairs, sortedBodies, num);
+	for (int i = numBodies; i < num; i++)
+	{
+		// Static geometry (planes, heightfields) would overlap everything, it is handled by the scene
+		if (bodies[i].shape->IsStaticGeometry())
+		{
+			continue;
+		}
+		PseudoBody endpoint;
+		endpoint.id = i;
+		endpoint.value = 0.0f;
+		endpoint.ismin = true;
+		endpoints.push_back(endpoint);
+		endpoint.ismin = false;
+		endpoints.push_back(endpoint);
+	}
+	numBodies = num;
 }
 
-void BroadPhase(const Body* bodies, const int num,	std::vector< CollisionPair >& finalPairs, const float dt_sec)
+void SweepAndPrune::RemapBodies(const int* remap, const int num)
 {
-	finalPairs.clear();
-	SweepAndPrune1D(bodies, num, finalPairs, dt_sec);
-}
\ No newline at end of file
+	int numKept = 0;
+	int numSortedKept = 0;
+	for (int i = 0; i < endpoints.size(); i++)
+	{
+		const int id = remap[endpoints[i].id];
+		if (id < 0)
+		{
+			continue;
+		}
+		endpoints[numKept] = endpoints[i];
+		endpoints[numKept].id = id;
+		numKept++;
+		if (i < numSorted)
+		{
+			numSortedKept++;
+		}
+	}
+	endpoints.resize(numKept);
+	numSorted = numSortedKept;
+	numBodies = num;
+}
+
+void SweepAndPrune::Update(const Body* bodies, const int num, std::vector<CollisionPair>& finalPairs, const float dt_sec, FrameArena& arena)
+{
+	if (num < numBodies)
+	{
+		Clear();
+	}
+	AddBodies(bodies, num);
+
+	float* minValues = arena.AllocateArray<float>(num);
+	float* maxValues = arena.AllocateArray<float>(num);
+	for (int i = 0; i < num; i++)
+	{
+		if (!bodies[i].shape->IsStaticGeometry())
+		{
+			ProjectBounds(bodies[i], dt_sec, minValues[i], maxValues[i]);
+		}
+	}
+	for (int i = 0; i < endpoints.size(); i++)
+	{
+		PseudoBody& endpoint = endpoints[i];
+		endpoint.value = endpoint.ismin ? minValues[endpoint.id] : maxValues[endpoint.id];
+	}
+
+	// Insertion sort of last step's order: each endpoint only moves past the few it crossed since
+	for (int i = 1; i < numSorted; i++)
+	{
+		const PseudoBody endpoint = endpoints[i];
+		int j = i - 1;
+		while (j >= 0 && LessSAP(endpoint, endpoints[j]))
+		{
+			endpoints[j + 1] = endpoints[j];
+			j--;
+		}
+		endpoints[j + 1] = endpoint;
+	}
+	if (numSorted < endpoints.size())
+	{
+		std::sort(endpoints.begin() + numSorted, endpoints.end(), LessSAP);
+		std::inplace_merge(endpoints.begin(), endpoints.begin() + numSorted, endpoints.end(), LessSAP);
+		numSorted = (int)endpoints.size();
+	}
+
+	BuildPairs(finalPairs, endpoints.data(), (int)endpoints.size() / 2);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include "Body.h"
+#include "code/Memory/FrameArena.h"
 
 struct CollisionPair
 {
@@ -25,4 +26,25 @@ struct PseudoBody
 };
 
 
-void BroadPhase(const Body* bodies, const int num, std::vector<CollisionPair>& finalPairs, const float dt_sec);
+/// <summary>
+/// Sweep and prune kept from one step to the next: bodies barely move in a step, so last step's order is almost sorted
+/// and an insertion sort puts it back in order in close to linear time. New bodies are sorted apart and merged in,
+/// removed ones are dropped without sorting anything. Pairs come out in endpoint order, lower bound first
+/// </summary>
+class SweepAndPrune
+{
+public:
+	SweepAndPrune() : numBodies(0), numSorted(0) {}
+
+	// Bodies appended to the array since the last call are added, a smaller array starts over
+	void Update(const Body* bodies, const int num, std::vector<CollisionPair>& finalPairs, const float dt_sec, FrameArena& arena);
+
+	void AddBodies(const Body* bodies, const int num);	// Catches up with the bodies appended to the array
+	void RemapBodies(const int* remap, const int num);	// remap[old index] = new index, -1 for removed bodies. Call AddBodies first
+	void Clear() { endpoints.clear(); numBodies = 0; numSorted = 0; }
+
+private:
+	std::vector<PseudoBody> endpoints;
+	int numBodies;
+	int numSorted;	// Endpoints in sorted order at the start of the array, the others were added since the last Update
+};
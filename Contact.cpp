@@ -1,6 +1,6 @@
 #include "Contact.h"
 
-void Contact::ResolveContact(Contact& contact)
+void Contact::ResolveContact(Contact& contact, const PositionCorrection& correction, const float dt_sec)
 {
 	Body* a = contact.a;
 	Body* b = contact.b;
@@ -70,29 +70,73 @@ void Contact::ResolveContact(Contact& contact)
 	a->ApplyImpulse(ptOnA, impulseFriction * -1.0f);
 	b->ApplyImpulse(ptOnB, impulseFriction * 1.0f);
 
-	// If object are interpenetrating, use this to set them on contact
+	// If object are interpenetrating, push them apart at the end of the step
 	if (contact.timeOfImpact == 0.0f)
 	{
-		const float tA = invMassA / (invMassA + invMassB);
-		const float tB = invMassB / (invMassA + invMassB);
-		const Vec3 d = ptOnB - ptOnA;
-
-		a->position += d * tA;
-		b->position -= d * tB;
+		ResolvePenetration(*a, *b, contact.GetPoint(), correction, dt_sec);
 	}
 }
 
+/// <summary>
+/// Pseudo impulse le long de la normale: spare A et B sans toucher  leurs vitesses relles
+/// </summary>
+void Contact::ResolvePenetration(Body& a, Body& b, const ContactPoint& point, const PositionCorrection& correction, const float dt_sec)
+{
+	const float pushOutSpeed = correction.GetPushOutSpeed(point.separationDistance, dt_sec);
+	if (pushOutSpeed <= 0.0f)
+		return;
+
+	const Vec3 n = point.normal;
+	const Vec3 rA = point.ptOnAWorldSpace - a.GetCenterOfMassWorldSpace();
+	const Vec3 rB = point.ptOnBWorldSpace - b.GetCenterOfMassWorldSpace();
+	const Vec3 angularJA = (a.GetInverseInertiaTensorWorldSpace() * rA.Cross(n)).Cross(rA);
+	const Vec3 angularJB = (b.GetInverseInertiaTensorWorldSpace() * rB.Cross(n)).Cross(rB);
+	const float normalMass = a.inverseMass + b.inverseMass + (angularJA + angularJB).Dot(n);
+	if (normalMass <= 0.0f)
+		return;
+
+	// Earlier contacts of the step may already be pushing these bodies apart
+	const Vec3 pseudoVelAb = (a.pseudoLinearVelocity + a.pseudoAngularVelocity.Cross(rA)) - (b.pseudoLinearVelocity + b.pseudoAngularVelocity.Cross(rB));
+	const float lambda = (pushOutSpeed - pseudoVelAb.Dot(n)) / normalMass;
+	if (lambda <= 0.0f)
+		return;
+
+	a.ApplyPseudoImpulse(point.ptOnAWorldSpace, n * lambda);
+	b.ApplyPseudoImpulse(point.ptOnBWorldSpace, n * -lambda);
+}
+
+ContactPoint Contact::GetPoint() const
+{
+	ContactPoint point;
+	point.ptOnAWorldSpace = ptOnAWorldSpace;
+	point.ptOnBWorldSpace = ptOnBWorldSpace;
+	point.normal = normal;
+	point.separationDistance = separationDistance;
+	return point;
+}
+
+ContactAnchor Contact::GetAnchor() const
+{
+	ContactAnchor anchor;
+	anchor.ptOnALocalSpace = ptOnALocalSpace;
+	anchor.ptOnBLocalSpace = ptOnBLocalSpace;
+	return anchor;
+}
+
 
 int Contact::CompareContact(const void* p1, const void* p2)
 {
 	const Contact& a = *(Contact*)p1;
-	const Contact& b = *(Contact*)p1;
-	if (a.timeOfImpact < b.timeOfImpact) {
-
-		return -1;
+	const Contact& b = *(Contact*)p2;
+	if (a.timeOfImpact != b.timeOfImpact) {
+		return (a.timeOfImpact < b.timeOfImpact) ? -1 : 1;
+	}
+	// Same time: order by bodies, they all live in the scene's array
+	if (a.a != b.a) {
+		return (a.a < b.a) ? -1 : 1;
 	}
-	else if (a.timeOfImpact == b.timeOfImpact) {
-		return -0;
+	if (a.b != b.b) {
+		return (a.b < b.b) ? -1 : 1;
 	}
-	return 1;
+	return 0;
 }
\ No newline at end of file
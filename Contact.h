@@ -1,6 +1,50 @@
 #pragma once
 #include "code/Math/Vector.h"
 #include "Body.h"
+
+/// <summary>
+/// Penetration is removed with pseudo velocities, in a pass kept apart from the velocity solve.
+/// Only the part deeper than the slop is corrected, a fraction of it per step
+/// </summary>
+struct PositionCorrection
+{
+	float baumgarte{ 0.2f };
+	float penetrationSlop{ 0.005f };
+
+	float GetPushOutSpeed(const float separationDistance, const float dt_sec) const
+	{
+		return baumgarte / dt_sec * fmaxf(-separationDistance - penetrationSlop, 0.0f);
+	}
+};
+
+/// <summary>
+/// Persistent contact point as the solvers see it, about half the size of a Contact.
+/// Its bodies are indices held by the manifold, its local points are kept apart in a ContactAnchor
+/// </summary>
+struct ContactPoint
+{
+	Vec3 ptOnAWorldSpace;
+	Vec3 ptOnBWorldSpace;
+	Vec3 normal;
+	float separationDistance{ 0.0f };
+
+	// Impulses accumulated on A while the contact persists, used to warm start the next step
+	float normalImpulse{ 0.0f };
+	Vec3 frictionImpulse;
+};
+
+/// <summary>
+/// Cold half of a persistent contact point: only read to refresh the manifold and to match new contacts
+/// </summary>
+struct ContactAnchor
+{
+	Vec3 ptOnALocalSpace;
+	Vec3 ptOnBLocalSpace;
+};
+
+/// <summary>
+/// Narrowphase result, lives for one step. The manifolds keep it as a ContactPoint and a ContactAnchor
+/// </summary>
 class Contact
 
 {
@@ -17,6 +61,10 @@ public:
 	Body* a{ nullptr };
 	Body* b{ nullptr };
 
-	static void ResolveContact(Contact& contact);
+	ContactPoint GetPoint() const;
+	ContactAnchor GetAnchor() const;
+
+	static void ResolveContact(Contact& contact, const PositionCorrection& correction, const float dt_sec);
+	static void ResolvePenetration(Body& a, Body& b, const ContactPoint& point, const PositionCorrection& correction, const float dt_sec);
 	static int CompareContact(const void* p1, const void* p2);
 };
\ No newline at end of file
@@ -0,0 +1,419 @@
+#include "ContactSolver.h"
+#include <float.h>
+
+void ContactSolver::Rows::Resize(const int num)
+{
+	linear.resize(num);
+	angularA.resize(num);
+	angularB.resize(num);
+	invInertiaA.resize(num);
+	invInertiaB.resize(num);
+	effectiveMass.resize(num);
+	impulse.resize(num);
+}
+
+void ContactSolver::Rows::Set(const int i, const Vec3& direction, const Vec3& rA, const Vec3& rB, const Mat3& invInertiaWorldA, const Mat3& invInertiaWorldB,
+								const float invMassA, const float invMassB)
+{
+	linear[i] = direction;
+	angularA[i] = rA.Cross(direction);
+	angularB[i] = rB.Cross(direction);
+	invInertiaA[i] = invInertiaWorldA * angularA[i];
+	invInertiaB[i] = invInertiaWorldB * angularB[i];
+
+	const float k = invMassA + invMassB + angularA[i].Dot(invInertiaA[i]) + angularB[i].Dot(invInertiaB[i]);
+	effectiveMass[i] = (k > 0.0f) ? 1.0f / k : 0.0f;
+}
+
+/// <summary>
+/// Vitesse relative de A par rapport  B le long de la direction, au point de contact
+/// </summary>
+float ContactSolver::Rows::GetRelativeSpeed(const int i, const Body& a, const Body& b) const
+{
+	return linear[i].Dot(a.linearVelocity - b.linearVelocity) + angularA[i].Dot(a.angularVelocity) - angularB[i].Dot(b.angularVelocity);
+}
+
+/// <summary>
+/// Applique lambda le long de la direction sur A et l'oppos sur B
+/// </summary>
+void ContactSolver::Rows::ApplyImpulse(const int i, Body& a, Body& b, const float lambda) const
+{
+	// Static bodies are shared by every color, they must not even be written
+	if (a.inverseMass != 0.0f)
+	{
+		a.linearVelocity += linear[i] * (lambda * a.inverseMass);
+		a.angularVelocity += invInertiaA[i] * lambda;
+	}
+	if (b.inverseMass != 0.0f)
+	{
+		b.linearVelocity -= linear[i] * (lambda * b.inverseMass);
+		b.angularVelocity -= invInertiaB[i] * lambda;
+	}
+}
+
+float ContactSolver::Rows::GetRelativePseudoSpeed(const int i, const Body& a, const Body& b) const
+{
+	return linear[i].Dot(a.pseudoLinearVelocity - b.pseudoLinearVelocity) + angularA[i].Dot(a.pseudoAngularVelocity) - angularB[i].Dot(b.pseudoAngularVelocity);
+}
+
+void ContactSolver::Rows::ApplyPseudoImpulse(const int i, Body& a, Body& b, const float lambda) const
+{
+	if (a.inverseMass != 0.0f)
+	{
+		a.pseudoLinearVelocity += linear[i] * (lambda * a.inverseMass);
+		a.pseudoAngularVelocity += invInertiaA[i] * lambda;
+	}
+	if (b.inverseMass != 0.0f)
+	{
+		b.pseudoLinearVelocity -= linear[i] * (lambda * b.inverseMass);
+		b.pseudoAngularVelocity -= invInertiaB[i] * lambda;
+	}
+}
+
+void ContactSolver::Solve(ManifoldCollector& manifolds, const IslandBuilder& islands, const int islandIndex, Body* bodies, const float dt_sec)
+{
+	const Island island = islands.GetIsland(islandIndex);
+	const bool hasThreads = (jobSystem != nullptr && jobSystem->GetNumThreads() > 1);
+	const bool isParallel = ((hasThreads || isDeterministic) && island.numManifolds >= minParallelManifolds);
+	if (!isParallel)
+	{
+		Prepare(manifolds, island, bodies, dt_sec);
+		WarmStart(0, numPoints);
+		for (int i = 0; i < iterations; i++)
+		{
+			SolveVelocities(0, numPoints);
+		}
+		for (int i = 0; i < positionIterations; i++)
+		{
+			SolvePositions(0, numPoints);
+		}
+		StoreImpulses();
+		return;
+	}
+
+	// Manifolds of one color share no dynamic body: each color is solved in parallel without locks
+	ColorManifolds(manifolds, islands, island, bodies);
+	Island coloredIsland = island;
+	coloredIsland.manifolds = coloredManifolds.data();
+	Prepare(manifolds, coloredIsland, bodies, dt_sec);
+
+	RunColors([this](const int begin, const int end) { WarmStart(begin, end); });
+	for (int i = 0; i < iterations; i++)
+	{
+		RunColors([this](const int begin, const int end) { SolveVelocities(begin, end); });
+	}
+	for (int i = 0; i < positionIterations; i++)
+	{
+		RunColors([this](const int begin, const int end) { SolvePositions(begin, end); });
+	}
+	StoreImpulses();
+}
+
+/// <summary>
+/// Reprend les rglages d'un autre solveur, sans ses buffers ni son job system
+/// </summary>
+void ContactSolver::CopySettings(const ContactSolver& other)
+{
+	iterations = other.iterations;
+	positionIterations = other.positionIterations;
+	tolerance = other.tolerance;
+	minParallelManifolds = other.minParallelManifolds;
+	manifoldsPerTask = other.manifoldsPerTask;
+	isDeterministic = other.isDeterministic;
+	positionCorrection = other.positionCorrection;
+}
+
+/// <summary>
+/// Coloration gloutonne: chaque manifold prend la plus petite couleur libre pour ses deux corps dynamiques.
+/// Les statiques ne comptent pas, un sol touch par toute une pile ne force pas une couleur par contact
+/// </summary>
+void ContactSolver::ColorManifolds(const ManifoldCollector& manifolds, const IslandBuilder& islands, const Island& island, const Body* bodies)
+{
+	bodyColors.assign(island.numBodies, 0);
+	manifoldColors.resize(island.numManifolds);
+	colorOffsets.assign(MAX_COLORS + 1, 0);
+
+	for (int m = 0; m < island.numManifolds; m++)
+	{
+		const Manifold& manifold = manifolds.manifolds[island.manifolds[m]];
+		const int indexA = (bodies[manifold.bodyA].inverseMass == 0.0f) ? -1 : islands.GetLocalIndex(manifold.bodyA);
+		const int indexB = (bodies[manifold.bodyB].inverseMass == 0.0f) ? -1 : islands.GetLocalIndex(manifold.bodyB);
+
+		unsigned long long used = 0;
+		if (indexA >= 0) used |= bodyColors[indexA];
+		if (indexB >= 0) used |= bodyColors[indexB];
+
+		// The last color gathers whatever does not fit, it is solved on one thread
+		int color = 0;
+		while (color < MAX_COLORS - 1 && (used & (1ull << color)) != 0)
+		{
+			color++;
+		}
+		if (color < MAX_COLORS - 1)
+		{
+			if (indexA >= 0) bodyColors[indexA] |= (1ull << color);
+			if (indexB >= 0) bodyColors[indexB] |= (1ull << color);
+		}
+		manifoldColors[m] = color;
+		colorOffsets[color + 1]++;
+	}
+
+	for (int c = 0; c < MAX_COLORS; c++)
+	{
+		colorOffsets[c + 1] += colorOffsets[c];
+	}
+	coloredManifolds.resize(island.numManifolds);
+	std::vector<int> cursor(colorOffsets.begin(), colorOffsets.end() - 1);
+	for (int m = 0; m < island.numManifolds; m++)
+	{
+		coloredManifolds[cursor[manifoldColors[m]]++] = island.manifolds[m];
+	}
+}
+
+/// <summary>
+/// Appelle func sur les points de chaque couleur, une couleur aprs l'autre, les manifolds d'une couleur en parallle
+/// </summary>
+void ContactSolver::RunColors(const std::function<void(const int, const int)>& func)
+{
+	for (int c = 0; c < MAX_COLORS; c++)
+	{
+		const int first = colorOffsets[c];
+		const int count = colorOffsets[c + 1] - first;
+		if (count == 0)
+			continue;
+
+		if (c == MAX_COLORS - 1 || jobSystem == nullptr)
+		{
+			func(manifoldPointOffsets[first], manifoldPointOffsets[first + count]);
+			continue;
+		}
+		jobSystem->ParallelFor(count, manifoldsPerTask, [&](const int begin, const int end)
+		{
+			func(manifoldPointOffsets[first + begin], manifoldPointOffsets[first + end]);
+		});
+	}
+}
+
+/// <summary>
+/// Mmes lignes que Solve, rsolues comme un LCP creux: une ligne normale et deux de friction par point,
+/// les bornes de friction suivent la ligne normale du mme point
+/// </summary>
+void ContactSolver::SolveBlockPGS(ManifoldCollector& manifolds, const IslandBuilder& islands, const int islandIndex, Body* bodies, const float dt_sec)
+{
+	const Island island = islands.GetIsland(islandIndex);
+	Prepare(manifolds, island, bodies, dt_sec);
+
+	// The LCP only knows the bodies of the island, by their position in it
+	lcpSystem.Clear(island.numBodies);
+	lcpWorkspace.x.resize(numPoints * 3);
+	for (int i = 0; i < numPoints; i++)
+	{
+		const Body& a = bodies[bodyA[i]];
+		const Body& b = bodies[bodyB[i]];
+		const int indexA = (a.inverseMass == 0.0f) ? -1 : islands.GetLocalIndex(bodyA[i]);
+		const int indexB = (b.inverseMass == 0.0f) ? -1 : islands.GetLocalIndex(bodyB[i]);
+
+		int normalRow = -1;
+		const Rows* directions[3] = { &normalRows, &tangentRows[0], &tangentRows[1] };
+		for (int k = 0; k < 3; k++)
+		{
+			const Rows& rows = *directions[k];
+			const Vec3 jacobian[4] = { rows.linear[i], rows.angularA[i], rows.linear[i] * -1.0f, rows.angularB[i] * -1.0f };
+			const Vec3 invMassJacobian[4] = { rows.linear[i] * a.inverseMass, rows.invInertiaA[i], rows.linear[i] * -b.inverseMass, rows.invInertiaB[i] * -1.0f };
+
+			// b = target speed - current speed
+			const float targetSpeed = (k == 0) ? velocityBias[i] : 0.0f;
+			const float rhs = targetSpeed - rows.GetRelativeSpeed(i, a, b);
+			const int row = lcpSystem.AddRow(indexA, indexB, jacobian, invMassJacobian, rhs, 0.0f, FLT_MAX);
+			if (k == 0)
+			{
+				normalRow = row;
+			}
+			else
+			{
+				lcpSystem.SetFriction(row, normalRow, friction[i]);
+			}
+			lcpWorkspace.x[row] = rows.impulse[i];
+		}
+	}
+
+	LCP_ProjectedGaussSeidel(lcpSystem, lcpWorkspace, iterations, tolerance);
+
+	for (int i = 0; i < island.numBodies; i++)
+	{
+		Body& body = bodies[island.bodies[i]];
+		body.linearVelocity += lcpWorkspace.deltaLinear[i];
+		body.angularVelocity += lcpWorkspace.deltaAngular[i];
+	}
+	for (int i = 0; i < numPoints; i++)
+	{
+		normalRows.impulse[i] = lcpWorkspace.x[i * 3 + 0];
+		tangentRows[0].impulse[i] = lcpWorkspace.x[i * 3 + 1];
+		tangentRows[1].impulse[i] = lcpWorkspace.x[i * 3 + 2];
+	}
+
+	// Penetration stays out of the LCP, same split impulse pass as Solve
+	for (int i = 0; i < positionIterations; i++)
+	{
+		SolvePositions(0, numPoints);
+	}
+	StoreImpulses();
+}
+
+/// <summary>
+/// Prcalcule Jacobiennes, masses effectives et vitesses cibles de tous les points, une fois par pas
+/// </summary>
+void ContactSolver::Prepare(ManifoldCollector& manifolds, const Island& island, Body* bodiesP, const float dt_sec)
+{
+	bodies = bodiesP;
+	manifoldPointOffsets.resize(island.numManifolds + 1);
+	numPoints = 0;
+	for (int m = 0; m < island.numManifolds; m++)
+	{
+		manifoldPointOffsets[m] = numPoints;
+		numPoints += manifolds.manifolds[island.manifolds[m]].numContacts;
+	}
+	manifoldPointOffsets[island.numManifolds] = numPoints;
+
+	bodyA.resize(numPoints);
+	bodyB.resize(numPoints);
+	contactPoints.resize(numPoints);
+	friction.resize(numPoints);
+	velocityBias.resize(numPoints);
+	pushOutSpeed.resize(numPoints);
+	pseudoImpulse.assign(numPoints, 0.0f);
+	normalRows.Resize(numPoints);
+	tangentRows[0].Resize(numPoints);
+	tangentRows[1].Resize(numPoints);
+
+	// Resting contacts would jitter with restitution, only bounce on real impacts
+	const float restitutionThreshold = 0.5f;
+
+	int point = 0;
+	for (int m = 0; m < island.numManifolds; m++)
+	{
+		Manifold& manifold = manifolds.manifolds[island.manifolds[m]];
+		Body* a = bodies + manifold.bodyA;
+		Body* b = bodies + manifold.bodyB;
+		const Mat3 invInertiaWorldA = a->GetInverseInertiaTensorWorldSpace();
+		const Mat3 invInertiaWorldB = b->GetInverseInertiaTensorWorldSpace();
+		const Vec3 centerA = a->GetCenterOfMassWorldSpace();
+		const Vec3 centerB = b->GetCenterOfMassWorldSpace();
+		const float elasticity = a->elasticity * b->elasticity;
+
+		for (int c = 0; c < manifold.numContacts; c++, point++)
+		{
+			ContactPoint& contact = manifold.points[c];
+			const Vec3 n = contact.normal;
+			const Vec3 rA = contact.ptOnAWorldSpace - centerA;
+			const Vec3 rB = contact.ptOnBWorldSpace - centerB;
+			Vec3 t0;
+			Vec3 t1;
+			n.GetOrtho(t0, t1);
+
+			bodyA[point] = manifold.bodyA;
+			bodyB[point] = manifold.bodyB;
+			contactPoints[point] = &contact;
+			friction[point] = a->friction * b->friction;
+			normalRows.Set(point, n, rA, rB, invInertiaWorldA, invInertiaWorldB, a->inverseMass, b->inverseMass);
+			tangentRows[0].Set(point, t0, rA, rB, invInertiaWorldA, invInertiaWorldB, a->inverseMass, b->inverseMass);
+			tangentRows[1].Set(point, t1, rA, rB, invInertiaWorldA, invInertiaWorldB, a->inverseMass, b->inverseMass);
+
+			// Start from last step's impulses, friction projected on the new tangents
+			normalRows.impulse[point] = contact.normalImpulse;
+			tangentRows[0].impulse[point] = contact.frictionImpulse.Dot(t0);
+			tangentRows[1].impulse[point] = contact.frictionImpulse.Dot(t1);
+
+			// Target normal speed: bounce or close a small gap. Penetration is left to the position pass
+			const float normalSpeed = normalRows.GetRelativeSpeed(point, *a, *b);
+			if (contact.separationDistance > 0.0f)
+			{
+				// Not touching yet, the bodies may close the gap during this step
+				velocityBias[point] = -contact.separationDistance / dt_sec;
+			}
+			else
+			{
+				velocityBias[point] = (normalSpeed < -restitutionThreshold) ? -elasticity * normalSpeed : 0.0f;
+			}
+			pushOutSpeed[point] = positionCorrection.GetPushOutSpeed(contact.separationDistance, dt_sec);
+		}
+	}
+}
+
+void ContactSolver::WarmStart(const int begin, const int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Body& a = bodies[bodyA[i]];
+		Body& b = bodies[bodyB[i]];
+		normalRows.ApplyImpulse(i, a, b, normalRows.impulse[i]);
+		tangentRows[0].ApplyImpulse(i, a, b, tangentRows[0].impulse[i]);
+		tangentRows[1].ApplyImpulse(i, a, b, tangentRows[1].impulse[i]);
+	}
+}
+
+/// <summary>
+/// Une itration: friction dans la bote de Coulomb de la normale courante, puis normale toujours positive
+/// </summary>
+void ContactSolver::SolveVelocities(const int begin, const int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Body& a = bodies[bodyA[i]];
+		Body& b = bodies[bodyB[i]];
+
+		const float maxFriction = friction[i] * normalRows.impulse[i];
+		for (int k = 0; k < 2; k++)
+		{
+			Rows& rows = tangentRows[k];
+			const float speed = rows.GetRelativeSpeed(i, a, b);
+			const float oldImpulse = rows.impulse[i];
+			float newImpulse = oldImpulse - speed * rows.effectiveMass[i];
+			newImpulse = fmaxf(-maxFriction, fminf(newImpulse, maxFriction));
+			rows.impulse[i] = newImpulse;
+			rows.ApplyImpulse(i, a, b, newImpulse - oldImpulse);
+		}
+
+		const float speed = normalRows.GetRelativeSpeed(i, a, b);
+		const float oldImpulse = normalRows.impulse[i];
+		const float newImpulse = fmaxf(oldImpulse + (velocityBias[i] - speed) * normalRows.effectiveMass[i], 0.0f);
+		normalRows.impulse[i] = newImpulse;
+		normalRows.ApplyImpulse(i, a, b, newImpulse - oldImpulse);
+	}
+}
+
+/// <summary>
+/// Split impulse: mmes lignes normales, sur les pseudo vitesses. Elles dplacent les bodies en fin de pas puis sont oublies
+/// </summary>
+void ContactSolver::SolvePositions(const int begin, const int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Body& a = bodies[bodyA[i]];
+		Body& b = bodies[bodyB[i]];
+		const float speed = normalRows.GetRelativePseudoSpeed(i, a, b);
+		const float oldImpulse = pseudoImpulse[i];
+		const float newImpulse = fmaxf(oldImpulse + (pushOutSpeed[i] - speed) * normalRows.effectiveMass[i], 0.0f);
+		pseudoImpulse[i] = newImpulse;
+		normalRows.ApplyPseudoImpulse(i, a, b, newImpulse - oldImpulse);
+	}
+}
+
+/// <summary>
+/// Range les impulses accumules dans les contacts des manifolds pour le warm start du pas suivant,
+/// et mesure l'erreur restante sur les vitesses normales
+/// </summary>
+void ContactSolver::StoreImpulses()
+{
+	residual = 0.0f;
+	for (int i = 0; i < numPoints; i++)
+	{
+		ContactPoint& contact = *contactPoints[i];
+		contact.normalImpulse = normalRows.impulse[i];
+		contact.frictionImpulse = tangentRows[0].linear[i] * tangentRows[0].impulse[i] + tangentRows[1].linear[i] * tangentRows[1].impulse[i];
+
+		// A pushing contact should reach its target speed exactly, a released one only not fall below it
+		const float error = velocityBias[i] - normalRows.GetRelativeSpeed(i, bodies[bodyA[i]], bodies[bodyB[i]]);
+		residual = fmaxf(residual, (normalRows.impulse[i] > 0.0f) ? fabsf(error) : error);
+	}
+}
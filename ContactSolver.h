@@ -0,0 +1,102 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "Manifold.h"
+#include "Island.h"
+#include "code/Math/LCP.h"
+#include "code/Threading/JobSystem.h"
+
+enum class SolverMode
+{
+	SOLVER_SINGLE_PASS,			// One pass of Manifold::ResolveContacts per step
+	SOLVER_SEQUENTIAL_IMPULSE,	// ContactSolver::Solve, several iterations over all the manifold points
+	SOLVER_BLOCK_PGS,			// ContactSolver::SolveBlockPGS, the same rows as a sparse LCP
+};
+
+/// <summary>
+/// Sequential impulses over the manifold points of one island.
+/// Jacobians and effective masses are computed once per step and kept as structure of arrays,
+/// the iterations only read them and accumulate clamped impulses.
+/// Penetration is removed afterwards by a split impulse pass on pseudo velocities, it never feeds the real velocities.
+/// With a job system, large islands are graph colored and every color is solved in parallel.
+/// Within a color no two manifolds share a dynamic body, so the order they run in does not change the result.
+/// </summary>
+class ContactSolver
+{
+public:
+	ContactSolver() : iterations(8), positionIterations(4), tolerance(1e-4f), jobSystem(nullptr), minParallelManifolds(64), manifoldsPerTask(16), isDeterministic(false), residual(0.0f), numPoints(0), bodies(nullptr) {}
+
+	void Solve(ManifoldCollector& manifolds, const IslandBuilder& islands, const int islandIndex, Body* bodies, const float dt_sec);
+	void SolveBlockPGS(ManifoldCollector& manifolds, const IslandBuilder& islands, const int island, Body* bodies, const float dt_sec);
+	void CopySettings(const ContactSolver& other);
+
+	int iterations;		// Maximum for the block PGS
+	int positionIterations;
+	float tolerance;	// Block PGS stops once no impulse changes more than this during an iteration
+
+	JobSystem* jobSystem;		// nullptr: everything on the calling thread
+	int minParallelManifolds;	// Smaller islands are not worth coloring
+	int manifoldsPerTask;
+	bool isDeterministic;		// Large islands are colored even without threads: the result does not depend on the thread count
+
+	PositionCorrection positionCorrection;
+
+	// Largest normal speed error left after the last solve, in m/s
+	float GetResidual() const { return residual; }
+
+private:
+	/// <summary>
+	/// One constraint direction for every point: J = (linear, angularA, -linear, -angularB)
+	/// </summary>
+	struct Rows
+	{
+		std::vector<Vec3> linear;
+		std::vector<Vec3> angularA;			// rA x direction
+		std::vector<Vec3> angularB;			// rB x direction
+		std::vector<Vec3> invInertiaA;		// I_A^-1 (rA x direction)
+		std::vector<Vec3> invInertiaB;		// I_B^-1 (rB x direction)
+		std::vector<float> effectiveMass;	// 1 / (J M^-1 J^T)
+		std::vector<float> impulse;			// Accumulated over the iterations
+
+		void Resize(const int num);
+		void Set(const int i, const Vec3& direction, const Vec3& rA, const Vec3& rB, const Mat3& invInertiaWorldA, const Mat3& invInertiaWorldB,
+					const float invMassA, const float invMassB);
+		float GetRelativeSpeed(const int i, const Body& a, const Body& b) const;
+		void ApplyImpulse(const int i, Body& a, Body& b, const float lambda) const;
+		float GetRelativePseudoSpeed(const int i, const Body& a, const Body& b) const;
+		void ApplyPseudoImpulse(const int i, Body& a, Body& b, const float lambda) const;
+	};
+
+	void Prepare(ManifoldCollector& manifolds, const Island& island, Body* bodies, const float dt_sec);
+	void WarmStart(const int begin, const int end);
+	void SolveVelocities(const int begin, const int end);
+	void SolvePositions(const int begin, const int end);
+	void StoreImpulses();
+
+	void ColorManifolds(const ManifoldCollector& manifolds, const IslandBuilder& islands, const Island& island, const Body* bodies);
+	void RunColors(const std::function<void(const int, const int)>& func);
+
+	static const int MAX_COLORS = 64;	// One bit per color in bodyColors
+
+	float residual;
+	int numPoints;
+	Body* bodies;						// The scene's array, the solve works on indices into it
+	std::vector<int> bodyA;
+	std::vector<int> bodyB;
+	std::vector<ContactPoint*> contactPoints;	// Where StoreImpulses writes back
+	std::vector<float> friction;
+	std::vector<float> velocityBias;
+	std::vector<float> pushOutSpeed;		// Target pseudo speed along the normal
+	std::vector<float> pseudoImpulse;		// Accumulated over the position iterations, never warm started
+	Rows normalRows;
+	Rows tangentRows[2];
+
+	std::vector<int> manifoldPointOffsets;		// First point of every prepared manifold
+	std::vector<unsigned long long> bodyColors;	// Colors already used by each island body
+	std::vector<int> manifoldColors;
+	std::vector<int> colorOffsets;				// Range of coloredManifolds for every color
+	std::vector<int> coloredManifolds;
+
+	LCP_SparseSystem lcpSystem;
+	LCP_Workspace lcpWorkspace;
+};
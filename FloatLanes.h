@@ -0,0 +1,178 @@
+#pragma once
+#include <math.h>
+
+#if !defined(PHYSICS_NO_SIMD) && defined(__AVX512F__)
+	#define LANES_AVX512
+	#include <immintrin.h>
+#elif !defined(PHYSICS_NO_SIMD) && defined(__AVX2__)
+	#define LANES_AVX2
+	#include <immintrin.h>
+#elif !defined(PHYSICS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define LANES_SSE
+	#include <emmintrin.h>
+#endif
+
+// Thin wrappers so the batch kernels are written once for every instruction set.
+// FloatLanes holds WIDTH floats, LaneMask one comparison result per lane.
+
+#if defined(LANES_AVX512)
+
+struct FloatLanes
+{
+	static const int WIDTH = 16;
+	__m512 v;
+	FloatLanes() {}
+	FloatLanes(__m512 x) : v(x) {}
+	FloatLanes(float f) : v(_mm512_set1_ps(f)) {}
+	static FloatLanes Load(const float* p) { return _mm512_load_ps(p); }
+	void Store(float* p) const { _mm512_store_ps(p, v); }
+};
+typedef __mmask16 LaneMask;
+
+inline FloatLanes operator + (FloatLanes a, FloatLanes b) { return _mm512_add_ps(a.v, b.v); }
+inline FloatLanes operator - (FloatLanes a, FloatLanes b) { return _mm512_sub_ps(a.v, b.v); }
+inline FloatLanes operator * (FloatLanes a, FloatLanes b) { return _mm512_mul_ps(a.v, b.v); }
+inline FloatLanes operator / (FloatLanes a, FloatLanes b) { return _mm512_div_ps(a.v, b.v); }
+inline FloatLanes Sqrt(FloatLanes a) { return _mm512_sqrt_ps(a.v); }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return _mm512_max_ps(a.v, b.v); }
+inline FloatLanes Truncate(FloatLanes a) { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+inline LaneMask LessThan(FloatLanes a, FloatLanes b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ); }
+inline LaneMask LessEqual(FloatLanes a, FloatLanes b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ); }
+inline LaneMask GreaterEqual(FloatLanes a, FloatLanes b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ); }
+inline LaneMask GreaterThan(FloatLanes a, FloatLanes b) { return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ); }
+inline LaneMask And(LaneMask a, LaneMask b) { return (LaneMask)(a & b); }
+inline LaneMask Select(LaneMask m, LaneMask a, LaneMask b) { return (LaneMask)((m & a) | (~m & b)); }
+inline FloatLanes Select(LaneMask m, FloatLanes a, FloatLanes b) { return _mm512_mask_blend_ps(m, b.v, a.v); }
+inline unsigned int MaskBits(LaneMask m) { return (unsigned int)m; }
+
+#elif defined(LANES_AVX2)
+
+struct FloatLanes
+{
+	static const int WIDTH = 8;
+	__m256 v;
+	FloatLanes() {}
+	FloatLanes(__m256 x) : v(x) {}
+	FloatLanes(float f) : v(_mm256_set1_ps(f)) {}
+	static FloatLanes Load(const float* p) { return _mm256_load_ps(p); }
+	void Store(float* p) const { _mm256_store_ps(p, v); }
+};
+typedef __m256 LaneMask;
+
+inline FloatLanes operator + (FloatLanes a, FloatLanes b) { return _mm256_add_ps(a.v, b.v); }
+inline FloatLanes operator - (FloatLanes a, FloatLanes b) { return _mm256_sub_ps(a.v, b.v); }
+inline FloatLanes operator * (FloatLanes a, FloatLanes b) { return _mm256_mul_ps(a.v, b.v); }
+inline FloatLanes operator / (FloatLanes a, FloatLanes b) { return _mm256_div_ps(a.v, b.v); }
+inline FloatLanes Sqrt(FloatLanes a) { return _mm256_sqrt_ps(a.v); }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return _mm256_max_ps(a.v, b.v); }
+inline FloatLanes Truncate(FloatLanes a) { return _mm256_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+inline LaneMask LessThan(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline LaneMask LessEqual(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline LaneMask GreaterEqual(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline LaneMask GreaterThan(FloatLanes a, FloatLanes b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline LaneMask And(LaneMask a, LaneMask b) { return _mm256_and_ps(a, b); }
+inline LaneMask Select(LaneMask m, LaneMask a, LaneMask b) { return _mm256_blendv_ps(b, a, m); }
+inline FloatLanes Select(LaneMask m, FloatLanes a, FloatLanes b) { return _mm256_blendv_ps(b.v, a.v, m); }
+inline unsigned int MaskBits(LaneMask m) { return (unsigned int)_mm256_movemask_ps(m); }
+
+#elif defined(LANES_SSE)
+
+struct FloatLanes
+{
+	static const int WIDTH = 4;
+	__m128 v;
+	FloatLanes() {}
+	FloatLanes(__m128 x) : v(x) {}
+	FloatLanes(float f) : v(_mm_set1_ps(f)) {}
+	static FloatLanes Load(const float* p) { return _mm_load_ps(p); }
+	void Store(float* p) const { _mm_store_ps(p, v); }
+};
+typedef __m128 LaneMask;
+
+inline FloatLanes operator + (FloatLanes a, FloatLanes b) { return _mm_add_ps(a.v, b.v); }
+inline FloatLanes operator - (FloatLanes a, FloatLanes b) { return _mm_sub_ps(a.v, b.v); }
+inline FloatLanes operator * (FloatLanes a, FloatLanes b) { return _mm_mul_ps(a.v, b.v); }
+inline FloatLanes operator / (FloatLanes a, FloatLanes b) { return _mm_div_ps(a.v, b.v); }
+inline FloatLanes Sqrt(FloatLanes a) { return _mm_sqrt_ps(a.v); }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return _mm_max_ps(a.v, b.v); }
+inline FloatLanes Truncate(FloatLanes a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)); }
+inline LaneMask LessThan(FloatLanes a, FloatLanes b) { return _mm_cmplt_ps(a.v, b.v); }
+inline LaneMask LessEqual(FloatLanes a, FloatLanes b) { return _mm_cmple_ps(a.v, b.v); }
+inline LaneMask GreaterEqual(FloatLanes a, FloatLanes b) { return _mm_cmpge_ps(a.v, b.v); }
+inline LaneMask GreaterThan(FloatLanes a, FloatLanes b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline LaneMask And(LaneMask a, LaneMask b) { return _mm_and_ps(a, b); }
+inline LaneMask Select(LaneMask m, LaneMask a, LaneMask b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline FloatLanes Select(LaneMask m, FloatLanes a, FloatLanes b) { return _mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v)); }
+inline unsigned int MaskBits(LaneMask m) { return (unsigned int)_mm_movemask_ps(m); }
+
+#else
+
+struct FloatLanes
+{
+	static const int WIDTH = 1;
+	float v;
+	FloatLanes() {}
+	FloatLanes(float f) : v(f) {}
+	static FloatLanes Load(const float* p) { return *p; }
+	void Store(float* p) const { *p = v; }
+};
+typedef bool LaneMask;
+
+inline FloatLanes operator + (FloatLanes a, FloatLanes b) { return a.v + b.v; }
+inline FloatLanes operator - (FloatLanes a, FloatLanes b) { return a.v - b.v; }
+inline FloatLanes operator * (FloatLanes a, FloatLanes b) { return a.v * b.v; }
+inline FloatLanes operator / (FloatLanes a, FloatLanes b) { return a.v / b.v; }
+inline FloatLanes Sqrt(FloatLanes a) { return sqrtf(a.v); }
+inline FloatLanes Max(FloatLanes a, FloatLanes b) { return (a.v > b.v) ? a.v : b.v; }
+inline FloatLanes Truncate(FloatLanes a) { return (float)(int)a.v; }
+inline LaneMask LessThan(FloatLanes a, FloatLanes b) { return a.v < b.v; }
+inline LaneMask LessEqual(FloatLanes a, FloatLanes b) { return a.v <= b.v; }
+inline LaneMask GreaterEqual(FloatLanes a, FloatLanes b) { return a.v >= b.v; }
+inline LaneMask GreaterThan(FloatLanes a, FloatLanes b) { return a.v > b.v; }
+inline LaneMask And(LaneMask a, LaneMask b) { return a && b; }
+inline LaneMask Select(LaneMask m, LaneMask a, LaneMask b) { return m ? a : b; }
+inline FloatLanes Select(LaneMask m, FloatLanes a, FloatLanes b) { return m ? a : b; }
+inline unsigned int MaskBits(LaneMask m) { return m ? 1u : 0u; }
+
+#endif
+
+/// <summary>
+/// Sine and cosine of every lane, they share the range reduction. Cephes' single precision polynomials:
+/// within a few ulps of sinf and cosf for 0 <= x up to a few thousand radians.
+/// x is brought back to [-pi/4, pi/4] around the nearest even multiple j of pi/4, the bits of j pick the polynomial and the signs
+/// </summary>
+inline void SinCos(const FloatLanes x, FloatLanes& sine, FloatLanes& cosine)
+{
+	typedef FloatLanes F;
+	const F zero(0.0f);
+	const F one(1.0f);
+	const F two(2.0f);
+	const F half(0.5f);
+
+	// j = ((int)(x * 4 / pi) + 1) & ~1
+	const F j = Truncate((Truncate(x * F(1.27323954473516f)) + one) * half) * two;
+
+	// x - j * pi / 4 in extended precision
+	F r = x - j * F(0.78515625f);
+	r = r - j * F(2.4187564849853515625e-4f);
+	r = r - j * F(3.77489497744594108e-8f);
+	const F z = r * r;
+
+	F cosPoly = ((F(2.443315711809948e-5f) * z - F(1.388731625493765e-3f)) * z + F(4.166664568298827e-2f)) * z * z;
+	cosPoly = (cosPoly - half * z) + one;
+	F sinPoly = ((F(-1.9515295891e-4f) * z + F(8.3321608736e-3f)) * z - F(1.6666654611e-1f)) * z * r;
+	sinPoly = sinPoly + r;
+
+	// Bits 1 and 2 of j, 0 or 1, exact as floats
+	const F k = j * half;
+	const F bit1 = k - Truncate(k * half) * two;
+	const F bit2 = Truncate(k * half) - Truncate(k * F(0.25f)) * two;
+
+	// Every other quarter turn swaps the polynomials
+	sine = Select(GreaterThan(bit1, zero), cosPoly, sinPoly);
+	cosine = Select(GreaterThan(bit1, zero), sinPoly, cosPoly);
+
+	// The sine is negative on the second half turn, the cosine when exactly one of the two bits is set
+	sine = Select(GreaterThan(bit2, zero), zero - sine, sine);
+	cosine = Select(GreaterThan((bit1 - bit2) * (bit1 - bit2), zero), zero - cosine, cosine);
+}
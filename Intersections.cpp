@@ -9,6 +9,12 @@
 /// <returns></returns>
 bool Intersections::Intersect(Body& a, Body& b, const float dt, Contact& contact)
 {
+	// La gomtrie statique est toujours en B, la normale va de B vers A
+	if (a.shape->IsStaticGeometry() && !b.shape->IsStaticGeometry())
+	{
+		return Intersect(b, a, dt, contact);
+	}
+
 	contact.a = &a;
 	contact.b = &b;
 	const Vec3 ab = b.position - a.position;
@@ -28,31 +34,304 @@ bool Intersections::Intersect(Body& a, Body& b, const float dt, Contact& contact
 
 		if (Intersections::SphereSphereDynamic(*sphereA, *sphereB,posA, posB, valA, velB, dt,contact.ptOnAWorldSpace, contact.ptOnBWorldSpace,contact.timeOfImpact))	//Si il y a une futur collision
 		{
-			// Step bodies forward to get local space collision points: Met  jour les collisions au temps du point d'impact pour mettre a jour les info du contact
-			a.Update(contact.timeOfImpact);
-			b.Update(contact.timeOfImpact);
+			BuildSphereSphereContact(a, b, contact);
+			return true;
+		}
+	}
+	else if (a.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE && b.shape->GetType() == Shape::ShapeType::SHAPE_PLANE)
+	{
+		return SpherePlaneDynamic(a, b, dt, contact);
+	}
+	else if (a.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE &&
+				(b.shape->GetType() == Shape::ShapeType::SHAPE_HEIGHTFIELD || b.shape->GetType() == Shape::ShapeType::SHAPE_TRIMESH))
+	{
+		return SphereTriangleShapeDynamic(a, b, dt, contact);
+	}
+	return false;
 
-			// Convert world space contacts to local space
-			contact.ptOnALocalSpace = a.WorldSpaceToBodySpace(contact.ptOnAWorldSpace);
-			contact.ptOnBLocalSpace = b.WorldSpaceToBodySpace(contact.ptOnBWorldSpace);
+}
 
-			Vec3 ab = a.position - b.position;
-			contact.normal = ab;
-			contact.normal.Normalize();
+/// <summary>
+/// Finit un contact sphre-sphre dont les points monde et le temps d'impact sont dj remplis
+/// (par SphereSphereDynamic ou par le test group de IntersectionsBatch)
+/// </summary>
+void Intersections::BuildSphereSphereContact(Body& a, Body& b, Contact& contact)
+{
+	const ShapeSphere* sphereA = static_cast<const ShapeSphere*>(a.shape);
+	const ShapeSphere* sphereB = static_cast<const ShapeSphere*>(b.shape);
+
+	contact.a = &a;
+	contact.b = &b;
 
-			// Unwind time step: Puis on remet les collisions  l'tape d'avant
-			a.Update(-contact.timeOfImpact);
-			b.Update(-contact.timeOfImpact);
+	// Copies stepped forward to get local space collision points: les bodies eux-mmes ne bougent pas,
+	// plusieurs paires d'un mme body peuvent tre testes en parallle
+	Body movedA = a;
+	Body movedB = b;
+	movedA.Update(contact.timeOfImpact);
+	movedB.Update(contact.timeOfImpact);
+
+	// Convert world space contacts to local space
+	contact.ptOnALocalSpace = movedA.WorldSpaceToBodySpace(contact.ptOnAWorldSpace);
+	contact.ptOnBLocalSpace = movedB.WorldSpaceToBodySpace(contact.ptOnBWorldSpace);
+
+	Vec3 ab = movedA.position - movedB.position;
+	contact.normal = ab;
+	contact.normal.Normalize();
+
+	// Calculate separation distance
+	float r = ab.GetMagnitude()	- (sphereA->radius + sphereB->radius);
+	contact.separationDistance = r;
+}
+
+/// <summary>
+/// Remplit les points en local space au temps d'impact, comme pour les sphres
+/// </summary>
+static void ComputeLocalSpacePoints(const Body& a, const Body& b, Contact& contact)
+{
+	Body movedA = a;
+	Body movedB = b;
+	movedA.Update(contact.timeOfImpact);
+	movedB.Update(contact.timeOfImpact);
+
+	contact.ptOnALocalSpace = movedA.WorldSpaceToBodySpace(contact.ptOnAWorldSpace);
+	contact.ptOnBLocalSpace = movedB.WorldSpaceToBodySpace(contact.ptOnBWorldSpace);
+}
+
+/// <summary>
+/// Sphre contre demi-espace: solution analytique, pas de perte de prcision comme avec une sphre gante
+/// </summary>
+bool Intersections::SpherePlaneDynamic(Body& sphere, Body& plane, const float dt, Contact& contact)
+{
+	const ShapeSphere* shapeSphere = static_cast<const ShapeSphere*>(sphere.shape);
+	const ShapePlane* shapePlane = static_cast<const ShapePlane*>(plane.shape);
+	const float radius = shapeSphere->radius;
+
+	const Vec3 n = plane.orientation.RotatePoint(shapePlane->normal);
+	const Vec3 center = sphere.GetCenterOfMassWorldSpace();
+	const Vec3 relativeVelocity = sphere.linearVelocity - plane.linearVelocity;
+
+	const float distance = n.Dot(center - plane.position) - radius;
+	const float normalSpeed = n.Dot(relativeVelocity);
+
+	float timeOfImpact;
+	if (distance <= 0.001f)
+	{
+		// Already touching or interpenetrating
+		timeOfImpact = 0.0f;
+	}
+	else if (normalSpeed < 0.0f && distance <= -normalSpeed * dt)
+	{
+		timeOfImpact = distance / -normalSpeed;
+	}
+	else
+	{
+		return false;
+	}
+
+	const Vec3 centerAtImpact = center + sphere.linearVelocity * timeOfImpact;
+	const Vec3 planePosAtImpact = plane.position + plane.linearVelocity * timeOfImpact;
+	const float centerDistance = n.Dot(centerAtImpact - planePosAtImpact);
+
+	contact.a = &sphere;
+	contact.b = &plane;
+	contact.normal = n;
+	contact.timeOfImpact = timeOfImpact;
+	contact.ptOnAWorldSpace = centerAtImpact - n * radius;
+	contact.ptOnBWorldSpace = centerAtImpact - n * centerDistance;
+	contact.separationDistance = centerDistance - radius;
+
+	ComputeLocalSpacePoints(sphere, plane, contact);
+	return true;
+}
+
+/// <summary>
+/// Sphre contre heightfield ou maillage: seuls les triangles sous le volume balay par la sphre sont tests
+/// (cellules de la grille ou feuilles de la BVH)
+/// </summary>
+bool Intersections::SphereTriangleShapeDynamic(Body& sphere, Body& triangleShape, const float dt, Contact& contact)
+{
+	const ShapeSphere* shapeSphere = static_cast<const ShapeSphere*>(sphere.shape);
+	const float radius = shapeSphere->radius;
 
-			// Calculate separation distance
-			float r = ab.GetMagnitude()	- (sphereA->radius + sphereB->radius);
-			contact.separationDistance = r;
+	// Everything is done in the triangle shape's body space
+	const Quat invOrient = triangleShape.orientation.Inverse();
+	const Vec3 center = triangleShape.WorldSpaceToBodySpace(sphere.GetCenterOfMassWorldSpace());
+	const Vec3 vel = invOrient.RotatePoint(sphere.linearVelocity - triangleShape.linearVelocity);
 
+	Bounds sweptBounds;
+	sweptBounds.Expand(center - Vec3(radius));
+	sweptBounds.Expand(center + Vec3(radius));
+	sweptBounds.Expand(center + vel * dt - Vec3(radius));
+	sweptBounds.Expand(center + vel * dt + Vec3(radius));
+
+	// One buffer per thread, the narrowphase runs in parallel
+	static thread_local std::vector<Vec3> tris;
+	tris.clear();
+	int numTris = 0;
+	if (triangleShape.shape->GetType() == Shape::ShapeType::SHAPE_HEIGHTFIELD)
+	{
+		numTris = static_cast<const ShapeHeightfield*>(triangleShape.shape)->GatherTriangles(sweptBounds, tris);
+	}
+	else
+	{
+		numTris = static_cast<const ShapeTriMesh*>(triangleShape.shape)->GatherTriangles(sweptBounds, tris);
+	}
+	if (0 == numTris)
+	{
+		return false;
+	}
+
+	Vec3 ptOnSphere;
+	Vec3 ptOnTri;
+	Vec3 normal;
+	float timeOfImpact;
+	if (!SphereTrianglesDynamic(center, vel, radius, tris.data(), numTris, dt, ptOnSphere, ptOnTri, normal, timeOfImpact))
+	{
+		return false;
+	}
+
+	contact.a = &sphere;
+	contact.b = &triangleShape;
+	contact.timeOfImpact = timeOfImpact;
+	contact.normal = triangleShape.orientation.RotatePoint(normal);
+	contact.separationDistance = (ptOnSphere - ptOnTri).Dot(normal);
+
+	// Back to world space, the triangle shape is moved to the time of impact too
+	const Vec3 offsetB = triangleShape.linearVelocity * timeOfImpact;
+	contact.ptOnAWorldSpace = triangleShape.BodySpaceToWorldSpace(ptOnSphere) + offsetB;
+	contact.ptOnBWorldSpace = triangleShape.BodySpaceToWorldSpace(ptOnTri) + offsetB;
+
+	ComputeLocalSpacePoints(sphere, triangleShape, contact);
+	return true;
+}
+
+/// <summary>
+/// Sphre en mouvement linaire contre une liste de triangles (3 sommets par triangle).
+/// Avancement conservatif: on avance du temps minimum pour couvrir la distance actuelle au triangle le plus proche
+/// </summary>
+/// <param name="ptOnSphere"> Point sur la sphre au temps d'impact </param>
+/// <param name="ptOnTri"> Point sur le triangle le plus proche au temps d'impact </param>
+/// <param name="normal"> Du triangle vers la sphre </param>
+bool Intersections::SphereTrianglesDynamic(const Vec3& center, const Vec3& vel, const float radius, const Vec3* tris, const int numTris, const float dt,
+												Vec3& ptOnSphere, Vec3& ptOnTri, Vec3& normal, float& timeOfImpact)
+{
+	const float tolerance = 0.001f;
+	const float speed = vel.GetMagnitude();
+
+	float t = 0.0f;
+	for (int iter = 0; iter < 32; iter++)
+	{
+		const Vec3 pos = center + vel * t;
+
+		// Closest triangle at time t
+		float minSeparation = 1e30f;
+		Vec3 bestPt;
+		Vec3 bestNormal;
+		for (int i = 0; i < numTris; i++)
+		{
+			const Vec3& a = tris[i * 3 + 0];
+			const Vec3& b = tris[i * 3 + 1];
+			const Vec3& c = tris[i * 3 + 2];
+
+			Vec3 triNormal = (b - a).Cross(c - a);
+			triNormal.Normalize();
+
+			bool onFace;
+			const Vec3 pt = ClosestPointOnTriangle(pos, a, b, c, onFace);
+			Vec3 delta = pos - pt;
+			const float dist = delta.GetMagnitude();
+
+			float separation;
+			Vec3 n;
+			if (onFace && delta.Dot(triNormal) < 0.0f)
+			{
+				// Center is behind the face
+				separation = -dist - radius;
+				n = triNormal;
+			}
+			else
+			{
+				separation = dist - radius;
+				n = (dist > 1e-6f) ? delta / dist : triNormal;
+			}
+
+			if (separation < minSeparation)
+			{
+				minSeparation = separation;
+				bestPt = pt;
+				bestNormal = n;
+			}
+		}
+
+		if (minSeparation <= tolerance)
+		{
+			timeOfImpact = t;
+			normal = bestNormal;
+			ptOnTri = bestPt;
+			ptOnSphere = pos - bestNormal * radius;
 			return true;
 		}
+
+		// The distance can't shrink faster than the speed
+		if (speed * (dt - t) < minSeparation)
+		{
+			return false;
+		}
+		t += minSeparation / speed;
 	}
 	return false;
+}
+
+/// <summary>
+/// Point le plus proche sur un triangle (Ericson, Real-Time Collision Detection 5.1.5)
+/// </summary>
+/// <param name="onFace"> true si le point est  l'intrieur de la face, false s'il est sur une arte ou un sommet </param>
+Vec3 Intersections::ClosestPointOnTriangle(const Vec3& pt, const Vec3& a, const Vec3& b, const Vec3& c, bool& onFace)
+{
+	onFace = false;
+	const Vec3 ab = b - a;
+	const Vec3 ac = c - a;
+	const Vec3 ap = pt - a;
+	const float d1 = ab.Dot(ap);
+	const float d2 = ac.Dot(ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+	const Vec3 bp = pt - b;
+	const float d3 = ab.Dot(bp);
+	const float d4 = ac.Dot(bp);
+	if (d3 >= 0.0f && d4 <= d3) return b;
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		const float v = d1 / (d1 - d3);
+		return a + ab * v;
+	}
+
+	const Vec3 cp = pt - c;
+	const float d5 = ab.Dot(cp);
+	const float d6 = ac.Dot(cp);
+	if (d6 >= 0.0f && d5 <= d6) return c;
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		const float w = d2 / (d2 - d6);
+		return a + ac * w;
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return b + (c - b) * w;
+	}
 
+	onFace = true;
+	const float denom = 1.0f / (va + vb + vc);
+	const float v = vb * denom;
+	const float w = vc * denom;
+	return a + ab * v + ac * w;
 }
 
 /// <summary>
@@ -11,4 +11,11 @@ public:
 	static bool RaySphere(const Vec3& rayStart, const Vec3& rayDir,	const Vec3& sphereCenter, const float sphereRadius, float& t0, float& t1);
 	static bool SphereSphereDynamic(const ShapeSphere& shapeA, const ShapeSphere& shapeB, const Vec3& posA, const Vec3& posB, const Vec3& velA, const Vec3& velB,
 													const float dt, Vec3& ptOnA, Vec3& ptOnB, float& timeOfImpact);
+	static void BuildSphereSphereContact(Body& a, Body& b, Contact& contact);
+
+	static bool SpherePlaneDynamic(Body& sphere, Body& plane, const float dt, Contact& contact);
+	static bool SphereTriangleShapeDynamic(Body& sphere, Body& triangleShape, const float dt, Contact& contact);
+	static bool SphereTrianglesDynamic(const Vec3& center, const Vec3& vel, const float radius, const Vec3* tris, const int numTris, const float dt,
+													Vec3& ptOnSphere, Vec3& ptOnTri, Vec3& normal, float& timeOfImpact);
+	static Vec3 ClosestPointOnTriangle(const Vec3& pt, const Vec3& a, const Vec3& b, const Vec3& c, bool& onFace);
 };
\ No newline at end of file
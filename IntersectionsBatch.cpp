@@ -0,0 +1,146 @@
+#include "IntersectionsBatch.h"
+#include "FloatLanes.h"
+#include <math.h>
+
+/// <summary>
+/// Un groupe de WIDTH paires, mmes tapes que SphereSphereDynamic + RaySphere mais sans early out:
+/// chaque condition de sortie devient un masque
+/// </summary>
+/// <returns> Hit bits for the lanes [first, first + WIDTH) </returns>
+static unsigned int SphereSphereLanes(const SphereSphereBatch& batch, const int first, const float dt, SphereSphereBatchResult& result)
+{
+	typedef FloatLanes F;
+	const F zero(0.0f);
+	const F one(1.0f);
+	const F dtLanes(dt);
+
+	const F posAx = F::Load(batch.posAx + first);
+	const F posAy = F::Load(batch.posAy + first);
+	const F posAz = F::Load(batch.posAz + first);
+	const F posBx = F::Load(batch.posBx + first);
+	const F posBy = F::Load(batch.posBy + first);
+	const F posBz = F::Load(batch.posBz + first);
+	const F velAx = F::Load(batch.velAx + first);
+	const F velAy = F::Load(batch.velAy + first);
+	const F velAz = F::Load(batch.velAz + first);
+	const F velBx = F::Load(batch.velBx + first);
+	const F velBy = F::Load(batch.velBy + first);
+	const F velBz = F::Load(batch.velBz + first);
+	const F radiusA = F::Load(batch.radiusA + first);
+	const F radiusB = F::Load(batch.radiusB + first);
+
+	// Ray of A relative to B, computed like the scalar version (end - start)
+	const F rayX = (posAx + (velAx - velBx) * dtLanes) - posAx;
+	const F rayY = (posAy + (velAy - velBy) * dtLanes) - posAy;
+	const F rayZ = (posAz + (velAz - velBz) * dtLanes) - posAz;
+	const F rayLengthSqr = rayX * rayX + rayY * rayY + rayZ * rayZ;
+
+	const F sX = posBx - posAx;
+	const F sY = posBy - posAy;
+	const F sZ = posBz - posAz;
+	const F distanceSqr = sX * sX + sY * sY + sZ * sZ;
+	const F radius = radiusA + radiusB;
+
+	// Ray is too short, just check if already intersecting
+	const LaneMask isShort = LessThan(rayLengthSqr, F(0.001f * 0.001f));
+	const F staticRadius = radius + F(0.001f);
+	const LaneMask overlaps = LessEqual(distanceSqr, staticRadius * staticRadius);
+
+	// Ray against the sphere of radius rA + rB around B
+	const F b = sX * rayX + sY * rayY + sZ * rayZ;
+	const F c = distanceSqr - radius * radius;
+	const F delta = b * b - rayLengthSqr * c;
+	const LaneMask rayHits = GreaterEqual(delta, zero);
+	const F inverseA = one / Select(isShort, one, rayLengthSqr);
+	const F deltaRoot = Sqrt(Max(delta, zero));
+	const F t0 = Select(isShort, zero, (b - deltaRoot) * inverseA * dtLanes);
+	const F t1 = Select(isShort, zero, (b + deltaRoot) * inverseA * dtLanes);
+
+	LaneMask hit = Select(isShort, overlaps, rayHits);
+	// Collision only in the past
+	hit = And(hit, GreaterEqual(t1, zero));
+	// Earliest positive time of impact, must happen during this frame
+	const F timeOfImpact = Max(t0, zero);
+	hit = And(hit, LessEqual(timeOfImpact, dtLanes));
+
+	// Points of collision at the time of impact
+	const F newPosAx = posAx + velAx * timeOfImpact;
+	const F newPosAy = posAy + velAy * timeOfImpact;
+	const F newPosAz = posAz + velAz * timeOfImpact;
+	const F newPosBx = posBx + velBx * timeOfImpact;
+	const F newPosBy = posBy + velBy * timeOfImpact;
+	const F newPosBz = posBz + velBz * timeOfImpact;
+
+	F abX = newPosBx - newPosAx;
+	F abY = newPosBy - newPosAy;
+	F abZ = newPosBz - newPosAz;
+	const F magnitude = Sqrt(abX * abX + abY * abY + abZ * abZ);
+	const LaneMask canNormalize = GreaterThan(magnitude, zero);
+	const F invMagnitude = one / Select(canNormalize, magnitude, one);
+	abX = Select(canNormalize, abX * invMagnitude, abX);
+	abY = Select(canNormalize, abY * invMagnitude, abY);
+	abZ = Select(canNormalize, abZ * invMagnitude, abZ);
+
+	timeOfImpact.Store(result.timeOfImpact + first);
+	(newPosAx + abX * radiusA).Store(result.ptOnAx + first);
+	(newPosAy + abY * radiusA).Store(result.ptOnAy + first);
+	(newPosAz + abZ * radiusA).Store(result.ptOnAz + first);
+	(newPosBx - abX * radiusB).Store(result.ptOnBx + first);
+	(newPosBy - abY * radiusB).Store(result.ptOnBy + first);
+	(newPosBz - abZ * radiusB).Store(result.ptOnBz + first);
+
+	return MaskBits(hit);
+}
+
+/// <summary>
+/// Recopie la paire 0 dans les lanes entre count et la fin du dernier registre : des sphres relles, sans NaN ni dnormaux
+/// </summary>
+static void PadUnusedLanes(SphereSphereBatch& batch)
+{
+	const int end = ((batch.count + FloatLanes::WIDTH - 1) / FloatLanes::WIDTH) * FloatLanes::WIDTH;
+	for (int i = batch.count; i < end; i++)
+	{
+		batch.posAx[i] = batch.posAx[0];
+		batch.posAy[i] = batch.posAy[0];
+		batch.posAz[i] = batch.posAz[0];
+		batch.posBx[i] = batch.posBx[0];
+		batch.posBy[i] = batch.posBy[0];
+		batch.posBz[i] = batch.posBz[0];
+		batch.velAx[i] = batch.velAx[0];
+		batch.velAy[i] = batch.velAy[0];
+		batch.velAz[i] = batch.velAz[0];
+		batch.velBx[i] = batch.velBx[0];
+		batch.velBy[i] = batch.velBy[0];
+		batch.velBz[i] = batch.velBz[0];
+		batch.radiusA[i] = batch.radiusA[0];
+		batch.radiusB[i] = batch.radiusB[0];
+	}
+}
+
+int SphereSphereDynamicBatch(SphereSphereBatch& batch, const float dt, SphereSphereBatchResult& result)
+{
+	if (batch.count > 0)
+	{
+		PadUnusedLanes(batch);
+	}
+
+	unsigned int hitMask = 0;
+	for (int first = 0; first < batch.count; first += FloatLanes::WIDTH)
+	{
+		hitMask |= SphereSphereLanes(batch, first, dt, result) << first;
+	}
+
+	// The padding lanes repeat pair 0, their hits don't count
+	if (batch.count < SphereSphereBatch::MAX_PAIRS)
+	{
+		hitMask &= (1u << batch.count) - 1u;
+	}
+	result.hitMask = hitMask;
+
+	int numHits = 0;
+	for (unsigned int bits = hitMask; bits != 0; bits &= bits - 1)
+	{
+		numHits++;
+	}
+	return numHits;
+}
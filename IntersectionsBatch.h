@@ -0,0 +1,50 @@
+#pragma once
+
+/// <summary>
+/// Sphere pairs laid out as structure of arrays so the continuous test can run several pairs per SIMD register.
+/// Lanes past count are padded by SphereSphereDynamicBatch, their results are not used.
+/// </summary>
+struct SphereSphereBatch
+{
+	static const int MAX_PAIRS = 16;
+
+	alignas(64) float posAx[MAX_PAIRS];
+	alignas(64) float posAy[MAX_PAIRS];
+	alignas(64) float posAz[MAX_PAIRS];
+	alignas(64) float posBx[MAX_PAIRS];
+	alignas(64) float posBy[MAX_PAIRS];
+	alignas(64) float posBz[MAX_PAIRS];
+
+	alignas(64) float velAx[MAX_PAIRS];
+	alignas(64) float velAy[MAX_PAIRS];
+	alignas(64) float velAz[MAX_PAIRS];
+	alignas(64) float velBx[MAX_PAIRS];
+	alignas(64) float velBy[MAX_PAIRS];
+	alignas(64) float velBz[MAX_PAIRS];
+
+	alignas(64) float radiusA[MAX_PAIRS];
+	alignas(64) float radiusB[MAX_PAIRS];
+
+	int count;
+};
+
+struct SphereSphereBatchResult
+{
+	alignas(64) float timeOfImpact[SphereSphereBatch::MAX_PAIRS];
+
+	alignas(64) float ptOnAx[SphereSphereBatch::MAX_PAIRS];
+	alignas(64) float ptOnAy[SphereSphereBatch::MAX_PAIRS];
+	alignas(64) float ptOnAz[SphereSphereBatch::MAX_PAIRS];
+	alignas(64) float ptOnBx[SphereSphereBatch::MAX_PAIRS];
+	alignas(64) float ptOnBy[SphereSphereBatch::MAX_PAIRS];
+	alignas(64) float ptOnBz[SphereSphereBatch::MAX_PAIRS];
+
+	unsigned int hitMask;	// Bit i is set when pair i collides during dt
+};
+
+/// <summary>
+/// Same test as Intersections::SphereSphereDynamic for a whole batch.
+/// Uses AVX-512, AVX2 or SSE depending on the compiler flags, or plain scalar code when PHYSICS_NO_SIMD is defined.
+/// </summary>
+/// <returns> The number of pairs that collide </returns>
+int SphereSphereDynamicBatch(SphereSphereBatch& batch, const float dt, SphereSphereBatchResult& result);
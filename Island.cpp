@@ -0,0 +1,135 @@
+#include "Island.h"
+
+/// <summary>
+/// Racine de l'ensemble du corps, en raccourcissant le chemin au passage
+/// </summary>
+int IslandBuilder::Find(int body)
+{
+	while (parents[body] != body)
+	{
+		parents[body] = parents[parents[body]];
+		body = parents[body];
+	}
+	return body;
+}
+
+/// <summary>
+/// Fusionne les deux ensembles, le plus petit sous le plus grand
+/// </summary>
+void IslandBuilder::Union(const int bodyA, const int bodyB)
+{
+	int rootA = Find(bodyA);
+	int rootB = Find(bodyB);
+	if (rootA == rootB)
+	{
+		return;
+	}
+	if (sizes[rootA] < sizes[rootB])
+	{
+		const int tmp = rootA;
+		rootA = rootB;
+		rootB = tmp;
+	}
+	parents[rootB] = rootA;
+	sizes[rootA] += sizes[rootB];
+}
+
+void IslandBuilder::Build(const Body* bodies, const int numBodies, const ManifoldCollector& manifolds, const Contact* contacts, const int numContacts)
+{
+	parents.resize(numBodies);
+	sizes.assign(numBodies, 1);
+	for (int i = 0; i < numBodies; i++)
+	{
+		parents[i] = i;
+	}
+
+	// Resting contacts and impacts of this step
+	for (int i = 0; i < manifolds.manifolds.size(); i++)
+	{
+		const Manifold& manifold = manifolds.manifolds[i];
+		if (bodies[manifold.bodyA].inverseMass != 0.0f && bodies[manifold.bodyB].inverseMass != 0.0f)
+		{
+			Union(manifold.bodyA, manifold.bodyB);
+		}
+	}
+	for (int i = 0; i < numContacts; i++)
+	{
+		const Contact& contact = contacts[i];
+		if (contact.a->inverseMass != 0.0f && contact.b->inverseMass != 0.0f)
+		{
+			Union((int)(contact.a - bodies), (int)(contact.b - bodies));
+		}
+	}
+
+	// One island per root, bodies grouped by island
+	islandOfRoot.assign(numBodies, -1);
+	islandOfBody.assign(numBodies, -1);
+	localIndex.assign(numBodies, -1);
+	bodyOffsets.assign(1, 0);
+	for (int i = 0; i < numBodies; i++)
+	{
+		if (bodies[i].inverseMass == 0.0f)
+			continue;
+		const int root = Find(i);
+		if (islandOfRoot[root] < 0)
+		{
+			islandOfRoot[root] = (int)bodyOffsets.size() - 1;
+			bodyOffsets.push_back(0);
+		}
+		islandOfBody[i] = islandOfRoot[root];
+		bodyOffsets[islandOfBody[i] + 1]++;
+	}
+	const int numIslands = (int)bodyOffsets.size() - 1;
+	for (int i = 0; i < numIslands; i++)
+	{
+		bodyOffsets[i + 1] += bodyOffsets[i];
+	}
+
+	islandBodies.resize(bodyOffsets[numIslands]);
+	std::vector<int> cursor(bodyOffsets.begin(), bodyOffsets.end() - 1);
+	for (int i = 0; i < numBodies; i++)
+	{
+		const int island = islandOfBody[i];
+		if (island < 0)
+			continue;
+		localIndex[i] = cursor[island] - bodyOffsets[island];
+		islandBodies[cursor[island]++] = i;
+	}
+
+	// Manifolds go to the island of their dynamic body
+	std::vector<int> manifoldIsland(manifolds.manifolds.size(), -1);
+	manifoldOffsets.assign(numIslands + 1, 0);
+	for (int i = 0; i < manifolds.manifolds.size(); i++)
+	{
+		const Manifold& manifold = manifolds.manifolds[i];
+		const int dynamicBody = (bodies[manifold.bodyA].inverseMass != 0.0f) ? manifold.bodyA : manifold.bodyB;
+		if (bodies[dynamicBody].inverseMass == 0.0f)
+			continue;
+		manifoldIsland[i] = islandOfBody[dynamicBody];
+		manifoldOffsets[manifoldIsland[i] + 1]++;
+	}
+	for (int i = 0; i < numIslands; i++)
+	{
+		manifoldOffsets[i + 1] += manifoldOffsets[i];
+	}
+
+	islandManifolds.resize(manifoldOffsets[numIslands]);
+	cursor.assign(manifoldOffsets.begin(), manifoldOffsets.end() - 1);
+	for (int i = 0; i < manifolds.manifolds.size(); i++)
+	{
+		if (manifoldIsland[i] >= 0)
+		{
+			islandManifolds[cursor[manifoldIsland[i]]++] = i;
+		}
+	}
+}
+
+Island IslandBuilder::GetIsland(const int island) const
+{
+	Island result;
+	result.bodies = islandBodies.data() + bodyOffsets[island];
+	result.numBodies = bodyOffsets[island + 1] - bodyOffsets[island];
+	result.manifolds = islandManifolds.data() + manifoldOffsets[island];
+	result.numManifolds = manifoldOffsets[island + 1] - manifoldOffsets[island];
+	return result;
+}
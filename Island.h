@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include "Body.h"
+#include "Manifold.h"
+
+/// <summary>
+/// Bodies coupled by contacts, solved independently of the rest of the world.
+/// Indices point into the scene bodies and into ManifoldCollector::manifolds.
+/// </summary>
+struct Island
+{
+	const int* bodies;
+	int numBodies;
+	const int* manifolds;
+	int numManifolds;
+};
+
+/// <summary>
+/// Union-find over the contact pairs of a step. Static bodies are never merged:
+/// a ground touched by two piles does not join them into one island.
+/// </summary>
+class IslandBuilder
+{
+public:
+	void Build(const Body* bodies, const int numBodies, const ManifoldCollector& manifolds, const Contact* contacts, const int numContacts);
+
+	int GetNumIslands() const { return (int)bodyOffsets.size() - 1; }
+	Island GetIsland(const int island) const;
+	int GetIslandOf(const int body) const { return islandOfBody[body]; }	// -1 for static bodies
+	int GetLocalIndex(const int body) const { return localIndex[body]; }	// Position of the body in its island
+
+private:
+	int Find(int body);
+	void Union(const int bodyA, const int bodyB);
+
+	std::vector<int> parents;
+	std::vector<int> sizes;
+	std::vector<int> islandOfRoot;
+
+	std::vector<int> islandOfBody;
+	std::vector<int> localIndex;
+	std::vector<int> bodyOffsets;
+	std::vector<int> islandBodies;
+	std::vector<int> manifoldOffsets;
+	std::vector<int> islandManifolds;
+};
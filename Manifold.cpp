@@ -0,0 +1,379 @@
+#include "Manifold.h"
+#include <algorithm>
+#include <float.h>
+
+/// <summary>
+/// Ajoute un contact au manifold. Si un point existant correspond (points locaux proches), on garde ses impulses accumules
+/// </summary>
+void Manifold::AddContact(const Contact& contact, const Body* bodies, ContactAnchor* anchors)
+{
+	// Keep the same body order as the manifold, the broadphase may give the pair swapped
+	ContactPoint point = contact.GetPoint();
+	ContactAnchor anchor = contact.GetAnchor();
+	if (contact.a != bodies + bodyA)
+	{
+		point.ptOnAWorldSpace = contact.ptOnBWorldSpace;
+		point.ptOnBWorldSpace = contact.ptOnAWorldSpace;
+		point.normal = contact.normal * -1.0f;
+		anchor.ptOnALocalSpace = contact.ptOnBLocalSpace;
+		anchor.ptOnBLocalSpace = contact.ptOnALocalSpace;
+	}
+
+	const float matchDistance = 0.02f;
+	for (int i = 0; i < numContacts; i++)
+	{
+		const Vec3 deltaA = anchors[i].ptOnALocalSpace - anchor.ptOnALocalSpace;
+		const Vec3 deltaB = anchors[i].ptOnBLocalSpace - anchor.ptOnBLocalSpace;
+		if (deltaA.GetLengthSqr() < matchDistance * matchDistance && deltaB.GetLengthSqr() < matchDistance * matchDistance)
+		{
+			point.normalImpulse = points[i].normalImpulse;
+			point.frictionImpulse = points[i].frictionImpulse;
+			points[i] = point;
+			anchors[i] = anchor;
+			return;
+		}
+	}
+
+	if (numContacts < MAX_CONTACTS)
+	{
+		points[numContacts] = point;
+		anchors[numContacts] = anchor;
+		numContacts++;
+		return;
+	}
+
+	// Full: keep the four points that best cover the contact area
+	ContactPoint candidates[MAX_CONTACTS + 1];
+	ContactAnchor candidateAnchors[MAX_CONTACTS + 1];
+	for (int i = 0; i < numContacts; i++)
+	{
+		candidates[i] = points[i];
+		candidateAnchors[i] = anchors[i];
+	}
+	candidates[numContacts] = point;
+	candidateAnchors[numContacts] = anchor;
+
+	int chosen[MAX_CONTACTS + 1];
+	numContacts = ReduceContacts(candidates, numContacts + 1, chosen);
+	for (int i = 0; i < numContacts; i++)
+	{
+		points[i] = candidates[chosen[i]];
+		anchors[i] = candidateAnchors[chosen[i]];
+	}
+}
+
+/// <summary>
+/// Rduit un ensemble de points de contact  MAX_CONTACTS au plus:
+/// le plus profond, le plus loin de celui-ci, celui qui donne le plus grand triangle, puis celui qui agrandit le plus le quadrilatre
+/// </summary>
+/// <returns> Number of candidates kept, their indices are written to chosen </returns>
+int Manifold::ReduceContacts(const ContactPoint* candidates, const int numCandidates, int* chosen)
+{
+	if (numCandidates <= MAX_CONTACTS)
+	{
+		for (int i = 0; i < numCandidates; i++)
+		{
+			chosen[i] = i;
+		}
+		return numCandidates;
+	}
+
+	// Areas are measured in the contact plane
+	const Vec3 normal = candidates[0].normal;
+	auto signedArea = [&normal](const Vec3& a, const Vec3& b, const Vec3& c)
+	{
+		return (b - a).Cross(c - a).Dot(normal);
+	};
+
+	// 1. Deepest point, it carries most of the load
+	chosen[0] = 0;
+	for (int i = 1; i < numCandidates; i++)
+	{
+		if (candidates[i].separationDistance < candidates[chosen[0]].separationDistance)
+		{
+			chosen[0] = i;
+		}
+	}
+	const Vec3 p0 = candidates[chosen[0]].ptOnAWorldSpace;
+
+	// 2. Farthest from the first one
+	chosen[1] = -1;
+	float best = -1.0f;
+	for (int i = 0; i < numCandidates; i++)
+	{
+		const float distanceSqr = (candidates[i].ptOnAWorldSpace - p0).GetLengthSqr();
+		if (i != chosen[0] && distanceSqr > best)
+		{
+			best = distanceSqr;
+			chosen[1] = i;
+		}
+	}
+	const Vec3 p1 = candidates[chosen[1]].ptOnAWorldSpace;
+
+	// 3. Largest triangle with the first two, on either side
+	chosen[2] = -1;
+	best = -1.0f;
+	float triangleArea = 0.0f;
+	for (int i = 0; i < numCandidates; i++)
+	{
+		if (i == chosen[0] || i == chosen[1])
+			continue;
+		const float area = signedArea(p0, p1, candidates[i].ptOnAWorldSpace);
+		if (fabsf(area) > best)
+		{
+			best = fabsf(area);
+			triangleArea = area;
+			chosen[2] = i;
+		}
+	}
+	const Vec3 p2 = candidates[chosen[2]].ptOnAWorldSpace;
+
+	// 4. The point that extends the triangle the most: largest area outside one of its edges
+	const float winding = (triangleArea < 0.0f) ? -1.0f : 1.0f;
+	chosen[3] = -1;
+	best = -FLT_MAX;
+	for (int i = 0; i < numCandidates; i++)
+	{
+		if (i == chosen[0] || i == chosen[1] || i == chosen[2])
+			continue;
+		const Vec3 p = candidates[i].ptOnAWorldSpace;
+		float outside = -winding * signedArea(p0, p1, p);
+		outside = std::max(outside, -winding * signedArea(p1, p2, p));
+		outside = std::max(outside, -winding * signedArea(p2, p0, p));
+		if (outside > best)
+		{
+			best = outside;
+			chosen[3] = i;
+		}
+	}
+
+	return MAX_CONTACTS;
+}
+
+/// <summary>
+/// Remet  jour les points monde depuis les points locaux et retire ceux qui se sont trop spars ou ont gliss
+/// </summary>
+void Manifold::RemoveExpired(Body* bodies, ContactAnchor* anchors)
+{
+	Body& a = bodies[bodyA];
+	Body& b = bodies[bodyB];
+
+	const float threshold = 0.02f;
+	for (int i = numContacts - 1; i >= 0; i--)
+	{
+		ContactPoint& point = points[i];
+		point.ptOnAWorldSpace = a.BodySpaceToWorldSpace(anchors[i].ptOnALocalSpace);
+		point.ptOnBWorldSpace = b.BodySpaceToWorldSpace(anchors[i].ptOnBLocalSpace);
+
+		// The normal goes from B to A, a positive distance means the bodies moved apart
+		const Vec3 ba = point.ptOnAWorldSpace - point.ptOnBWorldSpace;
+		const float distance = ba.Dot(point.normal);
+		const Vec3 tangential = ba - point.normal * distance;
+		point.separationDistance = distance;
+
+		if (distance > threshold || tangential.GetLengthSqr() > threshold * threshold)
+		{
+			points[i] = points[numContacts - 1];
+			anchors[i] = anchors[numContacts - 1];
+			numContacts--;
+		}
+	}
+}
+
+/// <summary>
+/// Applique les impulses de la frame prcdente pour partir d'une solution proche
+/// </summary>
+void Manifold::WarmStart(Body* bodies)
+{
+	for (int i = 0; i < numContacts; i++)
+	{
+		const ContactPoint& point = points[i];
+		const Vec3 impulse = point.normal * point.normalImpulse + point.frictionImpulse;
+		bodies[bodyA].ApplyImpulse(point.ptOnAWorldSpace, impulse);
+		bodies[bodyB].ApplyImpulse(point.ptOnBWorldSpace, impulse * -1.0f);
+	}
+}
+
+/// <summary>
+/// Rsout les contacts du manifold en accumulant les impulses: la normale reste positive et la friction dans le cne de Coulomb
+/// </summary>
+void Manifold::ResolveContacts(Body* bodies, const PositionCorrection& correction, const float dt_sec)
+{
+	Body* a = bodies + bodyA;
+	Body* b = bodies + bodyB;
+	if (a->inverseMass == 0.0f && b->inverseMass == 0.0f)
+	{
+		return;
+	}
+
+	const float invMassA = a->inverseMass;
+	const float invMassB = b->inverseMass;
+	const float elasticity = a->elasticity * b->elasticity;
+	const float friction = a->friction * b->friction;
+
+	// Resting contacts would jitter with restitution, only bounce on real impacts
+	const float restitutionThreshold = 0.5f;
+
+	const Mat3 inverseWorldInertiaA = a->GetInverseInertiaTensorWorldSpace();
+	const Mat3 inverseWorldInertiaB = b->GetInverseInertiaTensorWorldSpace();
+
+	for (int i = 0; i < numContacts; i++)
+	{
+		ContactPoint& contact = points[i];
+		const Vec3 n = contact.normal;
+		const Vec3 ptOnA = contact.ptOnAWorldSpace;
+		const Vec3 ptOnB = contact.ptOnBWorldSpace;
+		const Vec3 rA = ptOnA - a->GetCenterOfMassWorldSpace();
+		const Vec3 rB = ptOnB - b->GetCenterOfMassWorldSpace();
+
+		// Normal impulse
+		Vec3 velAb = (a->linearVelocity + a->angularVelocity.Cross(rA)) - (b->linearVelocity + b->angularVelocity.Cross(rB));
+		const float normalSpeed = velAb.Dot(n);
+
+		const Vec3 angularJA = (inverseWorldInertiaA * rA.Cross(n)).Cross(rA);
+		const Vec3 angularJB = (inverseWorldInertiaB * rB.Cross(n)).Cross(rB);
+		const float normalMass = invMassA + invMassB + (angularJA + angularJB).Dot(n);
+
+		// A kept point may still have a small gap: let the bodies close it during this step
+		const float e = (normalSpeed < -restitutionThreshold) ? elasticity : 0.0f;
+		const float gapSpeed = (contact.separationDistance > 0.0f) ? contact.separationDistance / dt_sec : 0.0f;
+		const float deltaImpulse = -((1.0f + e) * normalSpeed + gapSpeed) / normalMass;
+		const float oldImpulse = contact.normalImpulse;
+		contact.normalImpulse = fmaxf(oldImpulse + deltaImpulse, 0.0f);
+
+		const Vec3 impulse = n * (contact.normalImpulse - oldImpulse);
+		a->ApplyImpulse(ptOnA, impulse);
+		b->ApplyImpulse(ptOnB, impulse * -1.0f);
+
+		// Friction impulse, along the remaining tangential velocity
+		velAb = (a->linearVelocity + a->angularVelocity.Cross(rA)) - (b->linearVelocity + b->angularVelocity.Cross(rB));
+		const Vec3 velTangent = velAb - n * n.Dot(velAb);
+		const float tangentSpeed = velTangent.GetMagnitude();
+		if (tangentSpeed > 1e-6f)
+		{
+			const Vec3 t = velTangent / tangentSpeed;
+			const Vec3 inertiaA = (inverseWorldInertiaA * rA.Cross(t)).Cross(rA);
+			const Vec3 inertiaB = (inverseWorldInertiaB * rB.Cross(t)).Cross(rB);
+			const float tangentMass = invMassA + invMassB + (inertiaA + inertiaB).Dot(t);
+
+			const Vec3 oldFriction = contact.frictionImpulse;
+			Vec3 newFriction = oldFriction - t * (tangentSpeed / tangentMass);
+			const float maxFriction = friction * contact.normalImpulse;
+			if (newFriction.GetLengthSqr() > maxFriction * maxFriction)
+			{
+				newFriction.Normalize();
+				newFriction *= maxFriction;
+			}
+			contact.frictionImpulse = newFriction;
+
+			const Vec3 frictionImpulse = newFriction - oldFriction;
+			a->ApplyImpulse(ptOnA, frictionImpulse);
+			b->ApplyImpulse(ptOnB, frictionImpulse * -1.0f);
+		}
+	}
+
+	// Interpenetrating points push the bodies apart at the end of the step, apart from their velocities
+	for (int i = 0; i < numContacts; i++)
+	{
+		Contact::ResolvePenetration(*a, *b, points[i], correction, dt_sec);
+	}
+}
+
+/// <summary>
+/// Range le contact dans le manifold de sa paire de bodies, en le crant si besoin
+/// </summary>
+void ManifoldCollector::AddContact(const Contact& contact, const Body* bodies)
+{
+	const int indexA = (int)(contact.a - bodies);
+	const int indexB = (int)(contact.b - bodies);
+	const unsigned long long key = GetPairKey(indexA, indexB);
+	std::unordered_map<unsigned long long, int>::const_iterator it = pairSlots.find(key);
+	if (it != pairSlots.end())
+	{
+		manifolds[it->second].AddContact(contact, bodies, GetAnchors(it->second));
+		return;
+	}
+
+	pairSlots[key] = (int)manifolds.size();
+	manifolds.push_back(Manifold(indexA, indexB));
+	anchors.resize(manifolds.size() * Manifold::MAX_CONTACTS);
+	manifolds.back().AddContact(contact, bodies, GetAnchors((int)manifolds.size() - 1));
+}
+
+/// <summary>
+/// Rafrachit tous les manifolds et compacte ceux qui restent, avec leurs ancres
+/// </summary>
+void ManifoldCollector::RemoveExpired(Body* bodies)
+{
+	int numKept = 0;
+	for (int i = 0; i < manifolds.size(); i++)
+	{
+		manifolds[i].RemoveExpired(bodies, GetAnchors(i));
+		const unsigned long long key = GetPairKey(manifolds[i].bodyA, manifolds[i].bodyB);
+		if (0 == manifolds[i].numContacts)
+		{
+			pairSlots.erase(key);
+			continue;
+		}
+		if (numKept != i)
+		{
+			manifolds[numKept] = manifolds[i];
+			std::copy(GetAnchors(i), GetAnchors(i) + Manifold::MAX_CONTACTS, GetAnchors(numKept));
+			pairSlots[key] = numKept;
+		}
+		numKept++;
+	}
+	manifolds.resize(numKept);
+	anchors.resize(numKept * Manifold::MAX_CONTACTS);
+}
+
+/// <summary>
+/// Suit les corps dplacs dans le tableau de la scne, oublie ceux des corps supprims
+/// </summary>
+void ManifoldCollector::RemapBodies(const int* remap)
+{
+	// Every key changes with its bodies, the index is built again
+	pairSlots.clear();
+	int numKept = 0;
+	for (int i = 0; i < manifolds.size(); i++)
+	{
+		const int bodyA = remap[manifolds[i].bodyA];
+		const int bodyB = remap[manifolds[i].bodyB];
+		if (bodyA < 0 || bodyB < 0)
+			continue;
+		if (numKept != i)
+		{
+			manifolds[numKept] = manifolds[i];
+			std::copy(GetAnchors(i), GetAnchors(i) + Manifold::MAX_CONTACTS, GetAnchors(numKept));
+		}
+		manifolds[numKept].bodyA = bodyA;
+		manifolds[numKept].bodyB = bodyB;
+		pairSlots[GetPairKey(bodyA, bodyB)] = numKept;
+		numKept++;
+	}
+	manifolds.resize(numKept);
+	anchors.resize(numKept * Manifold::MAX_CONTACTS);
+}
+
+unsigned long long ManifoldCollector::GetPairKey(const int bodyA, const int bodyB)
+{
+	const unsigned int low = (unsigned int)std::min(bodyA, bodyB);
+	const unsigned int high = (unsigned int)std::max(bodyA, bodyB);
+	return ((unsigned long long)low << 32) | high;
+}
+
+void ManifoldCollector::WarmStart(Body* bodies)
+{
+	for (int i = 0; i < manifolds.size(); i++)
+	{
+		manifolds[i].WarmStart(bodies);
+	}
+}
+
+void ManifoldCollector::ResolveContacts(Body* bodies, const PositionCorrection& correction, const float dt_sec)
+{
+	for (int i = 0; i < manifolds.size(); i++)
+	{
+		manifolds[i].ResolveContacts(bodies, correction, dt_sec);
+	}
+}
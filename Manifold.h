@@ -0,0 +1,52 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Contact.h"
+
+/// <summary>
+/// Persistent contacts between two bodies, kept from one step to the next while their local points stay valid.
+/// Bodies are indices in the scene's array: a manifold outlives any reallocation of it.
+/// The anchors of the points are not stored here, the collector keeps them in a cold array
+/// </summary>
+class Manifold
+{
+public:
+	Manifold() : numContacts(0), bodyA(-1), bodyB(-1) {}
+	Manifold(const int a, const int b) : numContacts(0), bodyA(a), bodyB(b) {}
+
+	void AddContact(const Contact& contact, const Body* bodies, ContactAnchor* anchors);
+	void RemoveExpired(Body* bodies, ContactAnchor* anchors);
+	void WarmStart(Body* bodies);
+	void ResolveContacts(Body* bodies, const PositionCorrection& correction, const float dt_sec);
+
+	static const int MAX_CONTACTS = 4;
+	static int ReduceContacts(const ContactPoint* candidates, const int numCandidates, int* chosen);
+
+	ContactPoint points[MAX_CONTACTS];
+	int numContacts;
+
+	int bodyA;
+	int bodyB;
+};
+
+class ManifoldCollector
+{
+public:
+	void AddContact(const Contact& contact, const Body* bodies);
+	void RemoveExpired(Body* bodies);
+	void WarmStart(Body* bodies);
+	void ResolveContacts(Body* bodies, const PositionCorrection& correction, const float dt_sec);
+	void RemapBodies(const int* remap);	// remap[old index] = new index, the manifolds of removed bodies (-1) are dropped
+	void Clear() { manifolds.clear(); anchors.clear(); pairSlots.clear(); }
+
+	ContactAnchor* GetAnchors(const int manifold) { return anchors.data() + manifold * Manifold::MAX_CONTACTS; }
+	const ContactAnchor* GetAnchors(const int manifold) const { return anchors.data() + manifold * Manifold::MAX_CONTACTS; }
+
+	std::vector<Manifold> manifolds;
+	std::vector<ContactAnchor> anchors;	// MAX_CONTACTS per manifold, in the same order
+
+private:
+	static unsigned long long GetPairKey(const int bodyA, const int bodyB);
+
+	std::unordered_map<unsigned long long, int> pairSlots;	// Manifold of each body pair, whatever the order of the pair
+};
@@ -1,5 +1,23 @@
 #include "Shape.h"
 #include "code/Math/Matrix.h"
+#include <algorithm>
+
+void Shape::ComputeDerivedData()
+{
+	inertiaTensor = InertiaTensor();
+	inverseInertiaTensor = inertiaTensor.Inverse();
+	localBounds = GetBounds();
+
+	const float inertia = inertiaTensor.rows[0][0];
+	isSpherical = (centerOfMass == Vec3(0, 0, 0));
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			isSpherical = isSpherical && (inertiaTensor.rows[i][j] == ((i == j) ? inertia : 0.0f));
+		}
+	}
+}
 
 Mat3 ShapeSphere::InertiaTensor() const
 {
@@ -25,4 +43,316 @@ Bounds ShapeSphere::GetBounds() const
 	tmp.mins = Vec3(-radius);
 	tmp.maxs = Vec3(radius);
 	return tmp;
-}
\ No newline at end of file
+}
+
+Mat3 ShapePlane::InertiaTensor() const
+{
+	// Always static, an identity tensor just keeps Body::Update well defined
+	Mat3 tensor;
+	tensor.Identity();
+	return tensor;
+}
+
+Bounds ShapePlane::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+	Bounds tmp;
+	tmp.mins = Vec3(-renderExtent) + pos;
+	tmp.maxs = Vec3(renderExtent) + pos;
+	return tmp;
+}
+
+Bounds ShapePlane::GetBounds() const
+{
+	Bounds tmp;
+	tmp.mins = Vec3(-renderExtent);
+	tmp.maxs = Vec3(renderExtent);
+	return tmp;
+}
+
+ShapeHeightfield::ShapeHeightfield(int numXP, int numYP, float cellSizeP, const float* heightsP) : numX(numXP), numY(numYP), cellSize(cellSizeP)
+{
+	centerOfMass.Zero();
+	heights.assign(heightsP, heightsP + numX * numY);
+
+	minHeight = heights[0];
+	maxHeight = heights[0];
+	for (int i = 1; i < heights.size(); i++)
+	{
+		if (heights[i] < minHeight) minHeight = heights[i];
+		if (heights[i] > maxHeight) maxHeight = heights[i];
+	}
+	ComputeDerivedData();
+}
+
+Mat3 ShapeHeightfield::InertiaTensor() const
+{
+	Mat3 tensor;
+	tensor.Identity();
+	return tensor;
+}
+
+Bounds ShapeHeightfield::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+	// Transform the local box corners
+	Bounds local = GetBounds();
+	Vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i].x = (i & 1) ? local.maxs.x : local.mins.x;
+		corners[i].y = (i & 2) ? local.maxs.y : local.mins.y;
+		corners[i].z = (i & 4) ? local.maxs.z : local.mins.z;
+	}
+
+	Bounds tmp;
+	for (int i = 0; i < 8; i++)
+	{
+		tmp.Expand(orient.RotatePoint(corners[i]) + pos);
+	}
+	return tmp;
+}
+
+Bounds ShapeHeightfield::GetBounds() const
+{
+	const float halfX = 0.5f * (numX - 1) * cellSize;
+	const float halfY = 0.5f * (numY - 1) * cellSize;
+	Bounds tmp;
+	tmp.mins = Vec3(-halfX, -halfY, minHeight);
+	tmp.maxs = Vec3(halfX, halfY, maxHeight);
+	return tmp;
+}
+
+Vec3 ShapeHeightfield::GetVertex(int i, int j) const
+{
+	const float x = (i - 0.5f * (numX - 1)) * cellSize;
+	const float y = (j - 0.5f * (numY - 1)) * cellSize;
+	return Vec3(x, y, GetHeight(i, j));
+}
+
+/// <summary>
+/// Les deux triangles de la cellule (i, j), 6 sommets en body space, normales vers +Z
+/// </summary>
+void ShapeHeightfield::GetCellTriangles(int i, int j, Vec3* tris) const
+{
+	const Vec3 v00 = GetVertex(i, j);
+	const Vec3 v10 = GetVertex(i + 1, j);
+	const Vec3 v01 = GetVertex(i, j + 1);
+	const Vec3 v11 = GetVertex(i + 1, j + 1);
+
+	tris[0] = v00;
+	tris[1] = v10;
+	tris[2] = v11;
+
+	tris[3] = v00;
+	tris[4] = v11;
+	tris[5] = v01;
+}
+
+/// <summary>
+/// Ajoute les triangles des cellules qui chevauchent des bounds en body space
+/// </summary>
+/// <returns> Le nombre de triangles ajoutes </returns>
+int ShapeHeightfield::GatherTriangles(const Bounds& localBounds, std::vector<Vec3>& tris) const
+{
+	if (localBounds.mins.z > maxHeight || localBounds.maxs.z < minHeight)
+	{
+		return 0;
+	}
+
+	const float offsetX = 0.5f * (numX - 1);
+	const float offsetY = 0.5f * (numY - 1);
+	int i0 = (int)floorf(localBounds.mins.x / cellSize + offsetX);
+	int j0 = (int)floorf(localBounds.mins.y / cellSize + offsetY);
+	int i1 = (int)floorf(localBounds.maxs.x / cellSize + offsetX);
+	int j1 = (int)floorf(localBounds.maxs.y / cellSize + offsetY);
+	if (i0 < 0) i0 = 0;
+	if (j0 < 0) j0 = 0;
+	if (i1 > numX - 2) i1 = numX - 2;
+	if (j1 > numY - 2) j1 = numY - 2;
+
+	int numTris = 0;
+	for (int j = j0; j <= j1; j++)
+	{
+		for (int i = i0; i <= i1; i++)
+		{
+			// Skip cells entirely below the query
+			const float h0 = GetHeight(i, j);
+			const float h1 = GetHeight(i + 1, j);
+			const float h2 = GetHeight(i, j + 1);
+			const float h3 = GetHeight(i + 1, j + 1);
+			const float cellMax = fmaxf(fmaxf(h0, h1), fmaxf(h2, h3));
+			const float cellMin = fminf(fminf(h0, h1), fminf(h2, h3));
+			if (cellMax < localBounds.mins.z || cellMin > localBounds.maxs.z)
+			{
+				continue;
+			}
+
+			Vec3 cellTris[6];
+			GetCellTriangles(i, j, cellTris);
+			tris.insert(tris.end(), cellTris, cellTris + 6);
+			numTris += 2;
+		}
+	}
+	return numTris;
+}
+
+ShapeTriMesh::ShapeTriMesh(const Vec3* verts, const int numVerts, const unsigned int* idxs, const int numIdxs)
+{
+	centerOfMass.Zero();
+	vertices.assign(verts, verts + numVerts);
+	indices.assign(idxs, idxs + numIdxs);
+
+	const int numTris = GetNumTriangles();
+	std::vector<Vec3> centroids(numTris);
+	for (int i = 0; i < numTris; i++)
+	{
+		Vec3 pts[3];
+		GetTriangle(i, pts);
+		centroids[i] = (pts[0] + pts[1] + pts[2]) / 3.0f;
+	}
+
+	nodes.reserve(2 * numTris);
+	nodes.resize(1);
+	BuildNode(0, 0, numTris, centroids);
+	ComputeDerivedData();
+}
+
+/// <summary>
+/// Construit la BVH en coupant a la mediane sur le plus grand axe des centres.
+/// Les triangles (et leurs centres) sont reordonnes pour que chaque feuille soit contigue.
+/// </summary>
+void ShapeTriMesh::BuildNode(int nodeIdx, int firstTri, int numTris, std::vector<Vec3>& centroids)
+{
+	const int maxTrisPerLeaf = 4;
+
+	Bounds bounds;
+	Bounds centroidBounds;
+	for (int i = firstTri; i < firstTri + numTris; i++)
+	{
+		Vec3 pts[3];
+		GetTriangle(i, pts);
+		bounds.Expand(pts, 3);
+		centroidBounds.Expand(centroids[i]);
+	}
+	nodes[nodeIdx].bounds = bounds;
+
+	if (numTris <= maxTrisPerLeaf)
+	{
+		nodes[nodeIdx].first = firstTri;
+		nodes[nodeIdx].count = numTris;
+		return;
+	}
+
+	const float widths[3] = { centroidBounds.WidthX(), centroidBounds.WidthY(), centroidBounds.WidthZ() };
+	int axis = 0;
+	if (widths[1] > widths[axis]) axis = 1;
+	if (widths[2] > widths[axis]) axis = 2;
+
+	// Quickselect around the median, swapping whole triangles
+	const int mid = numTris / 2;
+	const int target = firstTri + mid;
+	int lo = firstTri;
+	int hi = firstTri + numTris - 1;
+	while (lo < hi)
+	{
+		const float pivot = centroids[(lo + hi) / 2][axis];
+		int i = lo;
+		int j = hi;
+		while (i <= j)
+		{
+			while (centroids[i][axis] < pivot) i++;
+			while (centroids[j][axis] > pivot) j--;
+			if (i <= j)
+			{
+				std::swap(centroids[i], centroids[j]);
+				for (int k = 0; k < 3; k++)
+				{
+					std::swap(indices[i * 3 + k], indices[j * 3 + k]);
+				}
+				i++;
+				j--;
+			}
+		}
+		if (target <= j) hi = j;
+		else if (target >= i) lo = i;
+		else break;
+	}
+
+	// Children are allocated next to each other so a single index is enough
+	const int firstChild = (int)nodes.size();
+	nodes.resize(firstChild + 2);
+	nodes[nodeIdx].first = firstChild;
+	nodes[nodeIdx].count = 0;
+
+	BuildNode(firstChild + 0, firstTri, mid, centroids);
+	BuildNode(firstChild + 1, firstTri + mid, numTris - mid, centroids);
+}
+
+Mat3 ShapeTriMesh::InertiaTensor() const
+{
+	Mat3 tensor;
+	tensor.Identity();
+	return tensor;
+}
+
+Bounds ShapeTriMesh::GetBounds(const Vec3& pos, const Quat& orient) const
+{
+	Bounds tmp;
+	for (int i = 0; i < vertices.size(); i++)
+	{
+		tmp.Expand(orient.RotatePoint(vertices[i]) + pos);
+	}
+	return tmp;
+}
+
+Bounds ShapeTriMesh::GetBounds() const
+{
+	return nodes[0].bounds;
+}
+
+void ShapeTriMesh::GetTriangle(int tri, Vec3* pts) const
+{
+	pts[0] = vertices[indices[tri * 3 + 0]];
+	pts[1] = vertices[indices[tri * 3 + 1]];
+	pts[2] = vertices[indices[tri * 3 + 2]];
+}
+
+/// <summary>
+/// Ajoute les triangles des feuilles de la BVH qui chevauchent des bounds en body space
+/// </summary>
+/// <returns> Le nombre de triangles ajoutes </returns>
+int ShapeTriMesh::GatherTriangles(const Bounds& localBounds, std::vector<Vec3>& tris) const
+{
+	if (nodes.empty())
+	{
+		return 0;
+	}
+
+	int numTris = 0;
+	int stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BvhNode& node = nodes[stack[--stackSize]];
+		if (!node.bounds.DoesIntersect(localBounds))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				Vec3 pts[3];
+				GetTriangle(i, pts);
+				tris.insert(tris.end(), pts, pts + 3);
+				numTris++;
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.first;
+		stack[stackSize++] = node.first + 1;
+	}
+	return numTris;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include "code/Math/Matrix.h"
 #include "code/Math/Bounds.h"
 #include "code/Math/Quat.h"
@@ -7,9 +8,14 @@ class Shape {
 public:
 	enum class ShapeType
 	{
-		SHAPE_SPHERE
+		SHAPE_SPHERE,
+		SHAPE_PLANE,
+		SHAPE_HEIGHTFIELD,
+		SHAPE_TRIMESH
 	};
 
+	virtual ~Shape() {}
+
 	virtual ShapeType GetType() const = 0;
 	virtual Mat3 InertiaTensor() const = 0;
 	virtual Vec3 GetCenterOfMass() const { return centerOfMass; }
@@ -17,8 +23,26 @@ public:
 	virtual Bounds GetBounds(const Vec3& pos, const Quat& orient) const = 0 ;
 	virtual Bounds GetBounds() const = 0;
 
+	// Static world geometry is kept out of the broadphase and tested directly against dynamic bodies
+	virtual bool IsStaticGeometry() const { return false; }
+
+	// Computed once when the shape is built: a shape does not change afterwards, bodies share it
+	const Mat3& GetInertiaTensor() const { return inertiaTensor; }
+	const Mat3& GetInverseInertiaTensor() const { return inverseInertiaTensor; }
+	const Bounds& GetLocalBounds() const { return localBounds; }
+
+	// Same inertia around every axis and center of mass at the origin, like a sphere:
+	// spinning has no gyroscopic torque and does not move the body
+	bool IsSpherical() const { return isSpherical; }
+
 protected:
+	void ComputeDerivedData();
+
 	Vec3 centerOfMass;
+	Mat3 inertiaTensor;
+	Mat3 inverseInertiaTensor;
+	Bounds localBounds;
+	bool isSpherical;
 };
 
 class ShapeSphere : public Shape {
@@ -26,6 +50,7 @@ public:
 	ShapeSphere(float radiusP) : radius(radiusP)
 	{
 		centerOfMass.Zero();
+		ComputeDerivedData();
 	}
 
 	ShapeType GetType() const override { return ShapeType::SHAPE_SPHERE; }
@@ -39,4 +64,89 @@ public:
 
 };
 
+/// <summary>
+/// Demi-espace infini: le plan passe par l'origine du body, la matiere est du cote oppose a la normale
+/// </summary>
+class ShapePlane : public Shape {
+public:
+	ShapePlane(const Vec3& normalP = Vec3(0, 0, 1), float renderExtentP = 100.0f) : normal(normalP), renderExtent(renderExtentP)
+	{
+		normal.Normalize();
+		centerOfMass.Zero();
+		ComputeDerivedData();
+	}
+
+	ShapeType GetType() const override { return ShapeType::SHAPE_PLANE; }
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	bool IsStaticGeometry() const override { return true; }
+
+	Vec3 normal;		// Body space
+	float renderExtent;	// Half size of the drawn patch, the collision plane itself is infinite
+};
+
+/// <summary>
+/// Grille de hauteurs reguliere dans le plan XY du body, centree sur l'origine. Chaque cellule est decoupee en deux triangles.
+/// </summary>
+class ShapeHeightfield : public Shape {
+public:
+	ShapeHeightfield(int numXP, int numYP, float cellSizeP, const float* heightsP);
 
+	ShapeType GetType() const override { return ShapeType::SHAPE_HEIGHTFIELD; }
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	bool IsStaticGeometry() const override { return true; }
+
+	float GetHeight(int i, int j) const { return heights[j * numX + i]; }
+	Vec3 GetVertex(int i, int j) const;
+	void GetCellTriangles(int i, int j, Vec3* tris) const;
+	int GatherTriangles(const Bounds& localBounds, std::vector<Vec3>& tris) const;
+
+	int numX;	// Number of samples along X
+	int numY;	// Number of samples along Y
+	float cellSize;
+	std::vector<float> heights;
+
+	float minHeight;
+	float maxHeight;
+};
+
+/// <summary>
+/// Maillage statique pour le decor. Les triangles sont ranges par feuille de la BVH construite au chargement.
+/// </summary>
+class ShapeTriMesh : public Shape {
+public:
+	ShapeTriMesh(const Vec3* verts, const int numVerts, const unsigned int* idxs, const int numIdxs);
+
+	ShapeType GetType() const override { return ShapeType::SHAPE_TRIMESH; }
+	Mat3 InertiaTensor() const override;
+
+	Bounds GetBounds(const Vec3& pos, const Quat& orient) const override;
+	Bounds GetBounds() const override;
+
+	bool IsStaticGeometry() const override { return true; }
+
+	int GetNumTriangles() const { return (int)indices.size() / 3; }
+	void GetTriangle(int tri, Vec3* pts) const;
+	int GatherTriangles(const Bounds& localBounds, std::vector<Vec3>& tris) const;
+
+	struct BvhNode
+	{
+		Bounds bounds;
+		int first;	// First child for inner nodes, first triangle for leaves
+		int count;	// Number of triangles, 0 for inner nodes
+	};
+
+	std::vector<Vec3> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<BvhNode> nodes;
+
+private:
+	void BuildNode(int nodeIdx, int firstTri, int numTris, std::vector<Vec3>& centroids);
+};
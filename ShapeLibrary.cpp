@@ -0,0 +1,99 @@
+#include "ShapeLibrary.h"
+
+bool ShapeLibrary::Key::operator<(const Key& rhs) const
+{
+	if (type != rhs.type)
+	{
+		return type < rhs.type;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		if (params[i] != rhs.params[i])
+		{
+			return params[i] < rhs.params[i];
+		}
+	}
+	return false;
+}
+
+Shape* ShapeLibrary::AddSphere(const float radius)
+{
+	const Key key = { Shape::ShapeType::SHAPE_SPHERE, { radius, 0.0f, 0.0f, 0.0f } };
+	std::lock_guard<std::mutex> lock(mutex);
+	return Intern(key);
+}
+
+Shape* ShapeLibrary::AddPlane(const Vec3& normal, const float renderExtent)
+{
+	const Key key = { Shape::ShapeType::SHAPE_PLANE, { normal.x, normal.y, normal.z, renderExtent } };
+	std::lock_guard<std::mutex> lock(mutex);
+	return Intern(key);
+}
+
+Shape* ShapeLibrary::Add(Shape* shape)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return Insert(shape);
+}
+
+Shape* ShapeLibrary::Insert(Shape* shape)
+{
+	indices[shape] = (int)shapes.size();
+	shapes.push_back(shape);
+	return shape;
+}
+
+/// <summary>
+/// Retourne la shape dj connue pour cette cl, sinon la construit et l'ajoute
+/// </summary>
+Shape* ShapeLibrary::Intern(const Key& key)
+{
+	std::map<Key, int>::const_iterator it = interned.find(key);
+	if (it != interned.end())
+	{
+		return shapes[it->second];
+	}
+
+	Shape* shape = nullptr;
+	if (key.type == Shape::ShapeType::SHAPE_SPHERE)
+	{
+		shape = new ShapeSphere(key.params[0]);
+	}
+	else
+	{
+		shape = new ShapePlane(Vec3(key.params[0], key.params[1], key.params[2]), key.params[3]);
+	}
+	interned[key] = (int)shapes.size();
+	return Insert(shape);
+}
+
+int ShapeLibrary::GetNumShapes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return (int)shapes.size();
+}
+
+Shape* ShapeLibrary::GetShape(const int index) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return shapes[index];
+}
+
+int ShapeLibrary::GetIndex(const Shape* shape) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::unordered_map<const Shape*, int>::const_iterator it = indices.find(shape);
+	return (it != indices.end()) ? it->second : -1;
+}
+
+void ShapeLibrary::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (int i = 0; i < shapes.size(); i++)
+	{
+		delete shapes[i];
+	}
+	shapes.clear();
+	interned.clear();
+	indices.clear();
+}
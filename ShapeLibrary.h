@@ -0,0 +1,51 @@
+#pragma once
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Shape.h"
+
+/// <summary>
+/// Owns the shapes of a scene, each one once: bodies with the same sphere or plane point to a single shared shape.
+/// Shapes never change once added, what bodies derive from them (inertia, bounds) is computed a single time.
+/// The index of a shape is compact and stable until Clear, for tables kept per shape such as the render models.
+/// Any thread may add and look up shapes while the physics thread steps: the renderer builds the models of new shapes
+/// </summary>
+class ShapeLibrary
+{
+public:
+	ShapeLibrary() {}
+	~ShapeLibrary() { Clear(); }
+
+	Shape* AddSphere(const float radius);
+	Shape* AddPlane(const Vec3& normal, const float renderExtent = 100.0f);
+	Shape* Add(Shape* shape);	// Takes ownership, never merged with another shape: heightfields, meshes
+
+	int GetNumShapes() const;
+	Shape* GetShape(const int index) const;
+	int GetIndex(const Shape* shape) const;	// -1 for a shape of another library
+
+	void Clear();
+
+private:
+	ShapeLibrary(const ShapeLibrary& rhs);
+	const ShapeLibrary& operator=(const ShapeLibrary& rhs);
+
+	/// <summary>
+	/// What makes two shapes identical: their type and construction parameters
+	/// </summary>
+	struct Key
+	{
+		Shape::ShapeType type;
+		float params[4];
+		bool operator<(const Key& rhs) const;
+	};
+
+	Shape* Intern(const Key& key);
+	Shape* Insert(Shape* shape);
+
+	mutable std::mutex mutex;
+	std::vector<Shape*> shapes;
+	std::map<Key, int> interned;
+	std::unordered_map<const Shape*, int> indices;
+};
@@ -0,0 +1,74 @@
+#include "TimeOfImpact.h"
+#include <algorithm>
+
+/// <summary>
+/// Vide la file pour un nouveau pas, tous les corps repartent du temps 0
+/// </summary>
+void TimeOfImpactQueue::Begin(Body* bodiesP, const int numBodies)
+{
+	bodies = bodiesP;
+	events.clear();
+	versions.assign(numBodies, 0);
+	bodyTimes.assign(numBodies, 0.0f);
+}
+
+void TimeOfImpactQueue::Push(const Contact& contact)
+{
+	Event event;
+	event.contact = contact;
+	event.versionA = versions[GetBodyIndex(contact.a)];
+	event.versionB = versions[GetBodyIndex(contact.b)];
+	events.push_back(event);
+	std::push_heap(events.begin(), events.end(), IsLater);
+}
+
+/// <summary>
+/// Sort le prochain vnement encore valide
+/// </summary>
+/// <returns> false when no event is left </returns>
+bool TimeOfImpactQueue::Pop(Contact& contact)
+{
+	while (!events.empty())
+	{
+		std::pop_heap(events.begin(), events.end(), IsLater);
+		const Event event = events.back();
+		events.pop_back();
+
+		// One of the bodies changed velocity since this event was predicted
+		if (event.versionA != versions[GetBodyIndex(event.contact.a)] || event.versionB != versions[GetBodyIndex(event.contact.b)])
+		{
+			continue;
+		}
+		contact = event.contact;
+		return true;
+	}
+	return false;
+}
+
+/// <summary>
+/// Intgre le corps de son temps courant jusqu' time
+/// </summary>
+void TimeOfImpactQueue::AdvanceBody(const int bodyIndex, const float time)
+{
+	const float dt = time - bodyTimes[bodyIndex];
+	if (dt > 0.0f)
+	{
+		bodies[bodyIndex].Update(dt);
+		bodyTimes[bodyIndex] = time;
+	}
+}
+
+/// <summary>
+/// Avance le curseur du corps jusqu' time sans l'intgrer
+/// </summary>
+/// <returns> The time the body still has to be integrated by, 0 when it is already there </returns>
+float TimeOfImpactQueue::TakeTimeTo(const int bodyIndex, const float time)
+{
+	const float dt = time - bodyTimes[bodyIndex];
+	if (dt > 0.0f)
+	{
+		bodyTimes[bodyIndex] = time;
+		return dt;
+	}
+	return 0.0f;
+}
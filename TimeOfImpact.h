@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "Contact.h"
+
+/// <summary>
+/// Continuous collision events of one step, earliest first.
+/// Every body has its own time cursor and a version that changes with its velocity:
+/// events predicted with an older version are dropped when popped.
+/// </summary>
+class TimeOfImpactQueue
+{
+public:
+	TimeOfImpactQueue() : bodies(nullptr) {}
+
+	void Begin(Body* bodiesP, const int numBodies);
+	void Push(const Contact& contact);
+	bool Pop(Contact& contact);
+
+	void AdvanceBody(const int bodyIndex, const float time);
+	float TakeTimeTo(const int bodyIndex, const float time);	// Like AdvanceBody, the caller integrates the returned time itself
+	void Invalidate(const int bodyIndex) { versions[bodyIndex]++; }
+	int GetBodyIndex(const Body* body) const { return (int)(body - bodies); }
+
+private:
+	struct Event
+	{
+		Contact contact;
+		unsigned int versionA;
+		unsigned int versionB;
+	};
+	static bool IsLater(const Event& a, const Event& b) { return a.contact.timeOfImpact > b.contact.timeOfImpact; }
+
+	Body* bodies;
+	std::vector<Event> events;	// Min-heap on the time of impact
+	std::vector<unsigned int> versions;
+	std::vector<float> bodyTimes;
+};
@@ -22,4 +22,123 @@ VecN LCP_GaussSeidel( const MatN & A, const VecN & b ) {
 		}
 	}
 	return x;
-}
\ No newline at end of file
+}
+
+/*
+====================================================
+LCP_SparseSystem::AddRow
+====================================================
+*/
+int LCP_SparseSystem::AddRow( const int bodyA, const int bodyB, const Vec3 * jacobian, const Vec3 * invMassJacobian, const float rhs, const float lo, const float hi ) {
+	LCP_Row row;
+	row.bodyA = bodyA;
+	row.bodyB = bodyB;
+	for ( int i = 0; i < 4; i++ ) {
+		row.jacobian[ i ] = jacobian[ i ];
+		row.invMassJacobian[ i ] = invMassJacobian[ i ];
+	}
+
+	row.diagonal = 0.0f;
+	for ( int i = 0; i < 4; i++ ) {
+		row.diagonal += row.jacobian[ i ].Dot( row.invMassJacobian[ i ] );
+	}
+	row.rhs = rhs;
+	row.lo = lo;
+	row.hi = hi;
+	row.frictionRow = -1;
+	row.friction = 0.0f;
+
+	rows.push_back( row );
+	return (int)rows.size() - 1;
+}
+
+/*
+====================================================
+LCP_SparseSystem::SetFriction
+====================================================
+*/
+void LCP_SparseSystem::SetFriction( const int row, const int normalRow, const float friction ) {
+	rows[ row ].frictionRow = normalRow;
+	rows[ row ].friction = friction;
+}
+
+/*
+====================================================
+LCP_ProjectedGaussSeidel
+Same sweep as LCP_GaussSeidel on A = J M^-1 J^T, but A x is read from the body velocity changes:
+( A x )_i = J_i . ( M^-1 J^T x ), only the blocks of the row's two bodies.
+====================================================
+*/
+int LCP_ProjectedGaussSeidel( const LCP_SparseSystem & system, LCP_Workspace & workspace, const int maxIterations, const float tolerance ) {
+	const int numRows = (int)system.rows.size();
+	std::vector< float > & x = workspace.x;
+	std::vector< Vec3 > & deltaLinear = workspace.deltaLinear;
+	std::vector< Vec3 > & deltaAngular = workspace.deltaAngular;
+
+	x.resize( numRows, 0.0f );
+	deltaLinear.assign( system.numBodies, Vec3( 0.0f ) );
+	deltaAngular.assign( system.numBodies, Vec3( 0.0f ) );
+
+	// Velocity changes of the initial guess
+	for ( int i = 0; i < numRows; i++ ) {
+		const LCP_Row & row = system.rows[ i ];
+		if ( row.bodyA >= 0 ) {
+			deltaLinear[ row.bodyA ] += row.invMassJacobian[ 0 ] * x[ i ];
+			deltaAngular[ row.bodyA ] += row.invMassJacobian[ 1 ] * x[ i ];
+		}
+		if ( row.bodyB >= 0 ) {
+			deltaLinear[ row.bodyB ] += row.invMassJacobian[ 2 ] * x[ i ];
+			deltaAngular[ row.bodyB ] += row.invMassJacobian[ 3 ] * x[ i ];
+		}
+	}
+
+	int iter = 0;
+	while ( iter < maxIterations ) {
+		iter++;
+		float maxChange = 0.0f;
+		for ( int i = 0; i < numRows; i++ ) {
+			const LCP_Row & row = system.rows[ i ];
+			if ( row.diagonal <= 0.0f ) {
+				continue;
+			}
+
+			float ax = 0.0f;
+			if ( row.bodyA >= 0 ) {
+				ax += row.jacobian[ 0 ].Dot( deltaLinear[ row.bodyA ] ) + row.jacobian[ 1 ].Dot( deltaAngular[ row.bodyA ] );
+			}
+			if ( row.bodyB >= 0 ) {
+				ax += row.jacobian[ 2 ].Dot( deltaLinear[ row.bodyB ] ) + row.jacobian[ 3 ].Dot( deltaAngular[ row.bodyB ] );
+			}
+
+			float lo = row.lo;
+			float hi = row.hi;
+			if ( row.frictionRow >= 0 ) {
+				hi = row.friction * x[ row.frictionRow ];
+				lo = -hi;
+			}
+
+			float newX = x[ i ] + ( row.rhs - ax ) / row.diagonal;
+			newX = ( newX < lo ) ? lo : ( ( newX > hi ) ? hi : newX );
+			const float dx = newX - x[ i ];
+			if ( !( dx * 0.0f == dx * 0.0f ) ) {
+				continue;
+			}
+			x[ i ] = newX;
+
+			if ( row.bodyA >= 0 ) {
+				deltaLinear[ row.bodyA ] += row.invMassJacobian[ 0 ] * dx;
+				deltaAngular[ row.bodyA ] += row.invMassJacobian[ 1 ] * dx;
+			}
+			if ( row.bodyB >= 0 ) {
+				deltaLinear[ row.bodyB ] += row.invMassJacobian[ 2 ] * dx;
+				deltaAngular[ row.bodyB ] += row.invMassJacobian[ 3 ] * dx;
+			}
+			maxChange = ( fabsf( dx ) > maxChange ) ? fabsf( dx ) : maxChange;
+		}
+
+		if ( maxChange < tolerance ) {
+			break;
+		}
+	}
+	return iter;
+}
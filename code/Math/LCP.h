@@ -4,6 +4,7 @@
 #pragma once
 #include "Vector.h"
 #include "Matrix.h"
+#include <vector>
 
 
 /*
@@ -11,4 +12,64 @@
 LCP_GaussSeidel
 ====================================================
 */
-VecN LCP_GaussSeidel( const MatN & A, const VecN & b );
\ No newline at end of file
+VecN LCP_GaussSeidel( const MatN & A, const VecN & b );
+
+/*
+====================================================
+LCP_Row
+One constraint row, J = [ linearA angularA linearB angularB ].
+Only the blocks of the two constrained bodies are stored, a body index of -1 means no dynamic body on that side.
+====================================================
+*/
+struct LCP_Row {
+	int bodyA;
+	int bodyB;
+	Vec3 jacobian[ 4 ];
+	Vec3 invMassJacobian[ 4 ];	// M^-1 J^T, same blocks
+	float diagonal;				// J M^-1 J^T
+	float rhs;					// b
+	float lo;
+	float hi;
+	int frictionRow;			// >= 0: bounds are +/- friction * x[ frictionRow ] (normal row of the same contact)
+	float friction;
+};
+
+/*
+====================================================
+LCP_SparseSystem
+A = J M^-1 J^T is never built, rows only keep their Jacobian blocks
+====================================================
+*/
+class LCP_SparseSystem {
+public:
+	LCP_SparseSystem() : numBodies( 0 ) {}
+
+	void Clear( const int numBodiesP ) { rows.clear(); numBodies = numBodiesP; }
+	int AddRow( const int bodyA, const int bodyB, const Vec3 * jacobian, const Vec3 * invMassJacobian, const float rhs, const float lo, const float hi );
+	void SetFriction( const int row, const int normalRow, const float friction );
+
+	int numBodies;
+	std::vector< LCP_Row > rows;
+};
+
+/*
+====================================================
+LCP_Workspace
+Kept between solves so that no memory is allocated once it has grown.
+x is the initial guess on input (warm start), the solution on output.
+deltaLinear/deltaAngular are the body velocity changes M^-1 J^T x.
+====================================================
+*/
+struct LCP_Workspace {
+	std::vector< float > x;
+	std::vector< Vec3 > deltaLinear;
+	std::vector< Vec3 > deltaAngular;
+};
+
+/*
+====================================================
+LCP_ProjectedGaussSeidel
+Stops when no x changed more than tolerance during a sweep
+====================================================
+*/
+int LCP_ProjectedGaussSeidel( const LCP_SparseSystem & system, LCP_Workspace & workspace, const int maxIterations, const float tolerance );
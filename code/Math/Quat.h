@@ -8,6 +8,8 @@
 /*
  ================================
  Quat
+ Stored w, x, y, z: one register for the SIMD backend, see Simd.h.
+ Not aligned, so the Quats inside Body and the snapshot arrays take no padding
  ================================
  */
 class Quat {
@@ -35,6 +37,8 @@ public:
 	Mat3	ToMat3() const;
 	Vec4	ToVec4() const { return Vec4( w, x, y, z ); }
 
+	static Quat Nlerp( const Quat & a, const Quat & b, const float t );
+
 public:
 	float w;
 	float x;
@@ -84,10 +88,14 @@ inline const Quat & Quat::operator = ( const Quat & rhs ) {
 }
 
 inline Quat & Quat::operator *= ( const float & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_storeu_ps( &w, _mm_mul_ps( _mm_loadu_ps( &w ), _mm_set1_ps( rhs ) ) );
+#else
     x *= rhs;
     y *= rhs;
     z *= rhs;
     w *= rhs;
+#endif
     return *this;
 }
 
@@ -102,29 +110,42 @@ inline Quat & Quat::operator *= ( const Quat & rhs ) {
 
 inline Quat Quat::operator * ( const Quat & rhs ) const {
 	Quat temp;	
+#if defined( MATH_SIMD )
+	_mm_storeu_ps( &temp.w, SimdQuatMultiply( _mm_loadu_ps( &w ), _mm_loadu_ps( &rhs.w ) ) );
+	return temp;
+#else
 	temp.w = ( w * rhs.w ) - ( x * rhs.x ) - ( y * rhs.y ) - ( z * rhs.z );
 	temp.x = ( x * rhs.w ) + ( w * rhs.x ) + ( y * rhs.z ) - ( z * rhs.y );
 	temp.y = ( y * rhs.w ) + ( w * rhs.y ) + ( z * rhs.x ) - ( x * rhs.z );
 	temp.z = ( z * rhs.w ) + ( w * rhs.z ) + ( x * rhs.y ) - ( y * rhs.x );
 	return temp;
+#endif
 }
 
 inline void Quat::Normalize() {
 	float invMag = 1.0f / GetMagnitude();
 	
 	if ( 0.0f * invMag == 0.0f * invMag ) {
+#if defined( MATH_SIMD )
+		_mm_storeu_ps( &w, _mm_mul_ps( _mm_loadu_ps( &w ), _mm_set1_ps( invMag ) ) );
+#else
 		x = x * invMag;
 		y = y * invMag;
 		z = z * invMag;
 		w = w * invMag;
+#endif
 	}
 }
 
 inline void Quat::Invert() {
     *this *= 1.0f / MagnitudeSquared();
+#if defined( MATH_SIMD )
+	_mm_storeu_ps( &w, _mm_xor_ps( _mm_loadu_ps( &w ), _mm_set_ps( -0.0f, -0.0f, -0.0f, 0.0f ) ) );
+#else
     x = -x;
     y = -y;
     z = -z;
+#endif
 }
 
 inline Quat Quat::Inverse() const {
@@ -134,7 +155,14 @@ inline Quat Quat::Inverse() const {
 }
 
 inline float Quat::MagnitudeSquared() const {
+#if defined( MATH_SIMD )
+	// Summed x, y, z then w like the scalar code
+	const __m128 q = _mm_loadu_ps( &w );
+	const __m128 squares = _mm_mul_ps( q, q );
+	return SimdSum4( _mm_shuffle_ps( squares, squares, _MM_SHUFFLE( 0, 3, 2, 1 ) ) );
+#else
     return ( ( x * x ) + ( y * y ) + ( z * z ) + ( w * w ) );
+#endif
 }
 
 inline float Quat::GetMagnitude() const {
@@ -142,9 +170,22 @@ inline float Quat::GetMagnitude() const {
 }
 
 inline Vec3 Quat::RotatePoint( const Vec3 & rhs ) const {
+#if defined( MATH_SIMD )
+	// q * v * q^-1 without a Quat in memory between the two products
+	const __m128 q = _mm_loadu_ps( &w );
+	const __m128 vector = _mm_set_ps( rhs.z, rhs.y, rhs.x, 0.0f );
+	const __m128 squares = _mm_mul_ps( q, q );
+	const float invMagSqr = 1.0f / SimdSum4( _mm_shuffle_ps( squares, squares, _MM_SHUFFLE( 0, 3, 2, 1 ) ) );
+	const __m128 inverse = _mm_xor_ps( _mm_mul_ps( q, _mm_set1_ps( invMagSqr ) ), _mm_set_ps( -0.0f, -0.0f, -0.0f, 0.0f ) );
+
+	Quat final;
+	_mm_storeu_ps( &final.w, SimdQuatMultiply( SimdQuatMultiply( q, vector ), inverse ) );
+	return Vec3( final.x, final.y, final.z );
+#else
 	Quat vector( rhs.x, rhs.y, rhs.z, 0.0f );
 	Quat final = *this * vector * Inverse();
 	return Vec3( final.x, final.y, final.z );
+#endif
 }
 
 inline bool Quat::IsValid() const {
@@ -163,6 +204,31 @@ inline bool Quat::IsValid() const {
 	return true;
 }
 
+/*
+ ================================
+ Quat::Nlerp
+ Normalized linear blend along the shortest arc, close enough to a slerp between two nearby orientations
+ ================================
+ */
+inline Quat Quat::Nlerp( const Quat & a, const Quat & b, const float t ) {
+	const float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	const float sign = ( dot < 0.0f ) ? -1.0f : 1.0f;
+
+	Quat q;
+#if defined( MATH_SIMD )
+	const __m128 qa = _mm_loadu_ps( &a.w );
+	const __m128 qb = _mm_mul_ps( _mm_loadu_ps( &b.w ), _mm_set1_ps( sign ) );
+	_mm_storeu_ps( &q.w, _mm_add_ps( qa, _mm_mul_ps( _mm_sub_ps( qb, qa ), _mm_set1_ps( t ) ) ) );
+#else
+	q.x = a.x + ( b.x * sign - a.x ) * t;
+	q.y = a.y + ( b.y * sign - a.y ) * t;
+	q.z = a.z + ( b.z * sign - a.z ) * t;
+	q.w = a.w + ( b.w * sign - a.w ) * t;
+#endif
+	q.Normalize();
+	return q;
+}
+
 inline Mat3 Quat::RotateMatrix( const Mat3 & rhs ) const {
 	Mat3 mat;
 	mat.rows[ 0 ] = RotatePoint( rhs.rows[ 0 ] );
@@ -0,0 +1,55 @@
+//
+//	Simd.h
+//
+#pragma once
+
+/*
+ ================================
+ SIMD backend of Vec4 and Quat
+
+ SSE2 is on every x64 CPU, so it is the default there. Define MATH_SCALAR to build the plain float code instead.
+ Both give the same bits: every lane does the operations of the scalar code, in the same order,
+ and the horizontal sums add the lanes one after the other rather than pairwise.
+ ================================
+ */
+#if !defined( MATH_SCALAR ) && ( defined( _M_X64 ) || defined( __SSE2__ ) )
+#define MATH_SIMD
+#include <emmintrin.h>
+
+inline __m128 SimdSplat( const __m128 v, const int lane ) {
+	switch ( lane ) {
+		case 0: return _mm_shuffle_ps( v, v, _MM_SHUFFLE( 0, 0, 0, 0 ) );
+		case 1: return _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+		case 2: return _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+		default: return _mm_shuffle_ps( v, v, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	}
+}
+
+// ( ( ( v0 + v1 ) + v2 ) + v3 ), the order of the scalar dot products
+inline float SimdSum4( const __m128 v ) {
+	__m128 sum = _mm_add_ss( v, SimdSplat( v, 1 ) );
+	sum = _mm_add_ss( sum, SimdSplat( v, 2 ) );
+	sum = _mm_add_ss( sum, SimdSplat( v, 3 ) );
+	return _mm_cvtss_f32( sum );
+}
+
+// Hamilton product of two quaternions stored w, x, y, z
+inline __m128 SimdQuatMultiply( const __m128 a, const __m128 b ) {
+	const __m128 signW = _mm_set_ps( 0.0f, 0.0f, 0.0f, -0.0f );
+
+	// Lane by lane: w*rw, x*rw, y*rw, z*rw
+	__m128 result = _mm_mul_ps( a, SimdSplat( b, 0 ) );
+
+	// -x*rx, w*rx, w*ry, w*rz
+	__m128 term = _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 0, 0, 0, 1 ) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE( 3, 2, 1, 1 ) ) );
+	result = _mm_add_ps( result, _mm_xor_ps( term, signW ) );
+
+	// -y*ry, y*rz, z*rx, x*ry
+	term = _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 1, 3, 2, 2 ) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE( 2, 1, 3, 2 ) ) );
+	result = _mm_add_ps( result, _mm_xor_ps( term, signW ) );
+
+	// -z*rz, -z*ry, -x*rz, -y*rx
+	term = _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 1, 3, 3 ) ), _mm_shuffle_ps( b, b, _MM_SHUFFLE( 1, 3, 2, 3 ) ) );
+	return _mm_sub_ps( result, term );
+}
+#endif
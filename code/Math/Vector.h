@@ -5,6 +5,7 @@
 #include <math.h>
 #include <assert.h>
 #include <stdio.h>
+#include "Simd.h"
 
 /*
  ================================
@@ -437,7 +438,7 @@ inline void Vec3::GetOrtho( Vec3 & u, Vec3 & v ) const {
  Vec4
  ================================
  */
-class Vec4 {
+class alignas( 16 ) Vec4 {
 public:
 	Vec4();
 	Vec4( const float value );
@@ -547,60 +548,88 @@ inline bool Vec4::operator != ( const Vec4 & rhs ) const {
 
 inline Vec4 Vec4::operator + ( const Vec4 & rhs ) const {
 	Vec4 temp;
+#if defined( MATH_SIMD )
+	_mm_store_ps( &temp.x, _mm_add_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	temp.x = x + rhs.x;
 	temp.y = y + rhs.y;
 	temp.z = z + rhs.z;
 	temp.w = w + rhs.w;
+#endif
 	return temp;
 }
 
 inline const Vec4 & Vec4::operator += ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_add_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	x += rhs.x;
 	y += rhs.y;
 	z += rhs.z;
 	w += rhs.w;
+#endif
 	return *this;
 }
 
 inline const Vec4 & Vec4::operator -= ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_sub_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	x -= rhs.x;
 	y -= rhs.y;
 	z -= rhs.z;
 	w -= rhs.w;
+#endif
 	return *this;
 }
 
 inline const Vec4 & Vec4::operator *= ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_mul_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	x *= rhs.x;
 	y *= rhs.y;
 	z *= rhs.z;
 	w *= rhs.w;
+#endif
 	return *this;
 }
 
 inline const Vec4 & Vec4::operator /= ( const Vec4 & rhs ) {
+#if defined( MATH_SIMD )
+	_mm_store_ps( &x, _mm_div_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	x /= rhs.x;
 	y /= rhs.y;
 	z /= rhs.z;
 	w /= rhs.w;
+#endif
 	return *this;
 }
 
 inline Vec4 Vec4::operator - ( const Vec4 & rhs ) const {
 	Vec4 temp;
+#if defined( MATH_SIMD )
+	_mm_store_ps( &temp.x, _mm_sub_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	temp.x = x - rhs.x;
 	temp.y = y - rhs.y;
 	temp.z = z - rhs.z;
 	temp.w = w - rhs.w;
+#endif
 	return temp;
 }
 
 inline Vec4 Vec4::operator * ( const float rhs ) const {
 	Vec4 temp;
+#if defined( MATH_SIMD )
+	_mm_store_ps( &temp.x, _mm_mul_ps( _mm_load_ps( &x ), _mm_set1_ps( rhs ) ) );
+#else
 	temp.x = x * rhs;
 	temp.y = y * rhs;
 	temp.z = z * rhs;
 	temp.w = w * rhs;
+#endif
 	return temp;
 }
 
@@ -615,21 +644,29 @@ inline float& Vec4::operator [] ( const int idx ) {
 }
 
 inline float Vec4::Dot( const Vec4 & rhs ) const {
+#if defined( MATH_SIMD )
+	return SimdSum4( _mm_mul_ps( _mm_load_ps( &x ), _mm_load_ps( &rhs.x ) ) );
+#else
 	float xx = x * rhs.x;
 	float yy = y * rhs.y;
 	float zz = z * rhs.z;
 	float ww = w * rhs.w;
 	return ( xx + yy + zz + ww );
+#endif
 }
 
 inline const Vec4 & Vec4::Normalize() {
 	float mag = GetMagnitude();
 	float invMag = 1.0f / mag;
 	if ( 0.0f * invMag == 0.0f * invMag ) {
+#if defined( MATH_SIMD )
+		_mm_store_ps( &x, _mm_mul_ps( _mm_load_ps( &x ), _mm_set1_ps( invMag ) ) );
+#else
 		x *= invMag;
 		y *= invMag;
 		z *= invMag;
 		w *= invMag;
+#endif
 	}
     
     return *this;
@@ -638,7 +675,11 @@ inline const Vec4 & Vec4::Normalize() {
 inline float Vec4::GetMagnitude() const {
 	float mag;
 	
+#if defined( MATH_SIMD )
+	mag = SimdSum4( _mm_mul_ps( _mm_load_ps( &x ), _mm_load_ps( &x ) ) );
+#else
 	mag = x * x + y * y + z * z + w * w;
+#endif
 	mag = sqrtf( mag );
 	
 	return mag;
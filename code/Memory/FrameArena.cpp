@@ -0,0 +1,108 @@
+//
+//	FrameArena.cpp
+//
+#include "FrameArena.h"
+#include <assert.h>
+#include <stdint.h>
+
+/*
+====================================================
+FrameArena::FrameArena
+====================================================
+*/
+FrameArena::FrameArena( const size_t initialSize ) :
+currentBlock( 0 ),
+offset( 0 ),
+used( 0 ),
+highWaterMark( 0 ),
+owner( std::this_thread::get_id() ) {
+	AddBlock( initialSize );
+}
+
+/*
+====================================================
+FrameArena::~FrameArena
+====================================================
+*/
+FrameArena::~FrameArena() {
+	for ( int i = 0; i < blocks.size(); i++ ) {
+		delete[] blocks[ i ].memory;
+	}
+	blocks.clear();
+}
+
+/*
+====================================================
+FrameArena::AddBlock
+====================================================
+*/
+void FrameArena::AddBlock( const size_t size ) {
+	Block block;
+	block.memory = new char[ size ];
+	block.size = size;
+	blocks.push_back( block );
+}
+
+/*
+====================================================
+FrameArena::Allocate
+====================================================
+*/
+void * FrameArena::Allocate( const size_t size, const size_t alignment ) {
+	assert( owner.load() == std::this_thread::get_id() );
+	while ( true ) {
+		const Block block = blocks[ currentBlock ];
+		const uintptr_t start = (uintptr_t)( block.memory + offset );
+		const uintptr_t aligned = ( start + alignment - 1 ) & ~(uintptr_t)( alignment - 1 );
+		const size_t end = offset + (size_t)( aligned - start ) + size;
+		if ( end <= block.size ) {
+			used += end - offset;
+			offset = end;
+			highWaterMark = ( used > highWaterMark ) ? used : highWaterMark;
+			return (void *)aligned;
+		}
+
+		// Full: the next block, a new one at least as large as all the others together
+		if ( currentBlock + 1 == blocks.size() ) {
+			const size_t capacity = GetCapacity();
+			AddBlock( ( size + alignment > capacity ) ? size + alignment : capacity );
+		}
+		used += block.size - offset;
+		currentBlock++;
+		offset = 0;
+	}
+}
+
+/*
+====================================================
+FrameArena::Reset
+====================================================
+*/
+void FrameArena::Reset() {
+	assert( owner.load() == std::this_thread::get_id() );
+	// The last step did not fit in one block: from now on one block holds it all
+	if ( blocks.size() > 1 ) {
+		const size_t capacity = GetCapacity();
+		for ( int i = 0; i < blocks.size(); i++ ) {
+			delete[] blocks[ i ].memory;
+		}
+		blocks.clear();
+		AddBlock( capacity );
+	}
+	currentBlock = 0;
+	offset = 0;
+	used = 0;
+}
+
+/*
+====================================================
+FrameArena::GetCapacity
+====================================================
+*/
+size_t FrameArena::GetCapacity() const {
+	size_t capacity = 0;
+	for ( int i = 0; i < blocks.size(); i++ ) {
+		capacity += blocks[ i ].size;
+	}
+	return capacity;
+}
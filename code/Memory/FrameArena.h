@@ -0,0 +1,70 @@
+//
+//	FrameArena.h
+//
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <string.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+====================================================
+FrameArena
+Linear allocator for the transient data of a step: allocating moves an offset, Reset frees everything at once.
+When a step needs more than the arena holds, another block is chained. Reset is then no longer free: it deletes
+the blocks and allocates a single one of their total size, so a steady workload ends up in one block and
+its Reset only rewinds the offset.
+Not thread safe: Allocate and Reset assert they run on the thread that took the arena last. A task that
+allocates takes it first and must not run alongside another one that does, parallel phases only write
+into arrays allocated before they start.
+====================================================
+*/
+class FrameArena {
+public:
+	explicit FrameArena( const size_t initialSize = 64 * 1024 );
+	~FrameArena();
+
+	void * Allocate( const size_t size, const size_t alignment = 16 );
+
+	// Uninitialized and never destroyed: every element is written before it is read
+	template< typename T >
+	T * AllocateArray( const int count ) {
+		static_assert( std::is_trivially_destructible< T >::value, "FrameArena never calls destructors" );
+		return (T *)Allocate( sizeof( T ) * count, alignof( T ) );
+	}
+
+	// Zero filled, for flags and counters
+	template< typename T >
+	T * AllocateZeroedArray( const int count ) {
+		T * items = AllocateArray< T >( count );
+		memset( items, 0, sizeof( T ) * count );
+		return items;
+	}
+
+	void TakeOwnership() { owner.store( std::this_thread::get_id() ); }
+	void Reset();
+
+	size_t GetUsed() const { return used; }
+	size_t GetHighWaterMark() const { return highWaterMark; }	// Most bytes used between two resets so far
+	size_t GetCapacity() const;
+
+private:
+	FrameArena( const FrameArena & rhs );
+	const FrameArena & operator = ( const FrameArena & rhs );
+
+	struct Block {
+		char * memory;
+		size_t size;
+	};
+
+	void AddBlock( const size_t size );
+
+	std::vector< Block > blocks;
+	int currentBlock;
+	size_t offset;	// In the current block
+	size_t used;
+	size_t highWaterMark;
+	std::atomic< std::thread::id > owner;
+};
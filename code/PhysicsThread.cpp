@@ -0,0 +1,233 @@
+//
+//  PhysicsThread.cpp
+//
+#include "PhysicsThread.h"
+#include <assert.h>
+
+typedef std::chrono::steady_clock Clock;
+
+/*
+====================================================
+PhysicsThread::Start
+====================================================
+*/
+void PhysicsThread::Start( Scene * physicsScene ) {
+	assert( !thread.joinable() );	// Stop first
+	scene = physicsScene;
+	scene->jobSystem = &jobSystem;
+	quit.store( false );
+
+	// Something to draw before the first tick
+	SavePreviousTransforms();
+	PublishSnapshot();
+
+	thread = std::thread( &PhysicsThread::Loop, this );
+}
+
+/*
+====================================================
+PhysicsThread::Stop
+====================================================
+*/
+void PhysicsThread::Stop() {
+	quit.store( true );
+	if ( thread.joinable() ) {
+		thread.join();
+	}
+
+	// The scene is handed back: it may outlive the job system, or be deleted before the destructor stops again
+	if ( nullptr != scene ) {
+		scene->jobSystem = nullptr;
+		scene = nullptr;
+	}
+}
+
+/*
+====================================================
+PhysicsThread::RequestSpawn
+====================================================
+*/
+void PhysicsThread::RequestSpawn( const Body * bodies, const int num ) {
+	std::lock_guard< std::mutex > lock( requestsMutex );
+	spawnRequests.insert( spawnRequests.end(), bodies, bodies + num );
+}
+
+/*
+====================================================
+PhysicsThread::RequestDespawn
+====================================================
+*/
+void PhysicsThread::RequestDespawn( const BodyHandle * handles, const int num ) {
+	std::lock_guard< std::mutex > lock( requestsMutex );
+	despawnRequests.insert( despawnRequests.end(), handles, handles + num );
+}
+
+/*
+====================================================
+PhysicsThread::GetInterpolationAlpha
+The snapshot is drawn from its previous to its current transforms during the tick after it was published
+====================================================
+*/
+float PhysicsThread::GetInterpolationAlpha( const TransformSnapshot & snapshot ) const {
+	if ( snapshot.isPaused || snapshot.tick_sec <= 0.0f ) {
+		return 1.0f;
+	}
+	const float elapsed_sec = std::chrono::duration< float >( Clock::now() - snapshot.publishTime ).count();
+	const float alpha = elapsed_sec / snapshot.tick_sec;
+	return ( alpha < 1.0f ) ? alpha : 1.0f;
+}
+
+/*
+====================================================
+PhysicsThread::Loop
+Fixed timestep: the real time goes into an accumulator, spent in whole ticks
+====================================================
+*/
+void PhysicsThread::Loop() {
+	const float tick_sec = 1.0f / tickRate;
+	float timeAccumulator = 0.0f;
+	Clock::time_point timeLastTick = Clock::now();
+
+	while ( !quit.load() ) {
+		const Clock::time_point time = Clock::now();
+		const float dt_sec = std::chrono::duration< float >( time - timeLastTick ).count();
+		timeLastTick = time;
+
+		if ( isResetRequested.exchange( false ) ) {
+			scene->Reset();
+			SavePreviousTransforms();
+			timeAccumulator = 0.0f;
+			PublishSnapshot();
+		}
+
+		// Shown right away, even while paused
+		if ( ApplyBodyRequests() ) {
+			PublishSnapshot();
+		}
+
+		int numSteps = 0;
+		const Clock::time_point startTime = Clock::now();
+		if ( isPaused.load() ) {
+			timeAccumulator = 0.0f;
+			if ( numStepRequests.load() > 0 ) {
+				numStepRequests.fetch_sub( 1 );
+				StepScene( tick_sec );
+				numSteps = 1;
+			}
+		} else {
+			numStepRequests.store( 0 );
+			timeAccumulator += dt_sec;
+			while ( timeAccumulator >= tick_sec && numSteps < maxStepsPerFrame ) {
+				StepScene( tick_sec );
+				timeAccumulator -= tick_sec;
+				numSteps++;
+			}
+
+			// Out of budget: the simulation runs slower than real time instead of falling further behind
+			if ( timeAccumulator >= tick_sec ) {
+				timeAccumulator = fmodf( timeAccumulator, tick_sec );
+			}
+		}
+
+		if ( numSteps > 0 ) {
+			updateMicroseconds.store( (int)std::chrono::duration_cast< std::chrono::microseconds >( Clock::now() - startTime ).count() );
+			PublishSnapshot();
+		}
+
+		// Nothing to do before the next tick is due
+		const float wait_sec = isPaused.load() ? 0.001f : ( tick_sec - timeAccumulator );
+		if ( wait_sec > 0.0f ) {
+			std::this_thread::sleep_for( std::chrono::duration< float >( wait_sec ) );
+		}
+	}
+}
+
+/*
+====================================================
+PhysicsThread::ApplyBodyRequests
+Despawns go first: their handles name bodies that already exist, none of the bodies spawned now
+====================================================
+*/
+bool PhysicsThread::ApplyBodyRequests() {
+	{
+		std::lock_guard< std::mutex > lock( requestsMutex );
+		if ( spawnRequests.empty() && despawnRequests.empty() ) {
+			return false;
+		}
+		spawnBodies.swap( spawnRequests );
+		despawnHandles.swap( despawnRequests );
+	}
+
+	if ( !despawnHandles.empty() ) {
+		scene->DespawnBodies( despawnHandles.data(), (int)despawnHandles.size() );
+	}
+	if ( !spawnBodies.empty() ) {
+		scene->SpawnBodies( spawnBodies.data(), (int)spawnBodies.size(), nullptr );
+	}
+	spawnBodies.clear();
+	despawnHandles.clear();
+	return true;
+}
+
+/*
+====================================================
+PhysicsThread::StepScene
+====================================================
+*/
+void PhysicsThread::StepScene( const float dt_sec ) {
+	SavePreviousTransforms();
+	scene->Update( dt_sec );
+}
+
+/*
+====================================================
+PhysicsThread::SavePreviousTransforms
+====================================================
+*/
+void PhysicsThread::SavePreviousTransforms() {
+	previousRevision = scene->GetBodiesRevision();
+	previousPositions.resize( scene->bodies.size() );
+	previousOrientations.resize( scene->bodies.size() );
+	for ( int i = 0; i < scene->bodies.size(); i++ ) {
+		previousPositions[ i ] = scene->bodies[ i ].position;
+		previousOrientations[ i ] = scene->bodies[ i ].orientation;
+	}
+}
+
+/*
+====================================================
+PhysicsThread::PublishSnapshot
+====================================================
+*/
+void PhysicsThread::PublishSnapshot() {
+	// Bodies were added or removed since the previous transforms were saved: they are drawn where they are
+	if ( scene->GetBodiesRevision() != previousRevision ) {
+		SavePreviousTransforms();
+	}
+	if ( scene->GetBodiesRevision() != shapesRevision ) {
+		shapeIndices.resize( scene->bodies.size() );
+		handles.resize( scene->bodies.size() );
+		for ( int i = 0; i < scene->bodies.size(); i++ ) {
+			shapeIndices[ i ] = scene->shapes.GetIndex( scene->bodies[ i ].shape );
+			handles[ i ] = scene->GetHandle( i );
+		}
+		shapesRevision = scene->GetBodiesRevision();
+	}
+
+	TransformSnapshot & snapshot = snapshots.GetWriteBuffer();
+	snapshot.positions.resize( scene->bodies.size() );
+	snapshot.orientations.resize( scene->bodies.size() );
+	for ( int i = 0; i < scene->bodies.size(); i++ ) {
+		snapshot.positions[ i ] = scene->bodies[ i ].position;
+		snapshot.orientations[ i ] = scene->bodies[ i ].orientation;
+	}
+	snapshot.previousPositions = previousPositions;
+	snapshot.previousOrientations = previousOrientations;
+	snapshot.shapeIndices = shapeIndices;
+	snapshot.handles = handles;
+	snapshot.publishTime = Clock::now();
+	snapshot.tick_sec = 1.0f / tickRate;
+	snapshot.isPaused = isPaused.load();
+
+	snapshots.Publish();
+}
@@ -0,0 +1,105 @@
+//
+//  PhysicsThread.h
+//
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Math/Vector.h"
+#include "Math/Quat.h"
+#include "Threading/JobSystem.h"
+#include "Threading/TripleBuffer.h"
+#include "Scene.h"
+
+/*
+====================================================
+TransformSnapshot
+Body transforms at the end of a physics tick and at the end of the tick before, for interpolation
+====================================================
+*/
+struct TransformSnapshot {
+	std::vector< Vec3 > positions;
+	std::vector< Quat > orientations;
+	std::vector< Vec3 > previousPositions;
+	std::vector< Quat > previousOrientations;
+	std::vector< int > shapeIndices;	// Index in the scene's shape library of each body
+	std::vector< BodyHandle > handles;	// What to pass to RequestDespawn for each body
+
+	std::chrono::steady_clock::time_point publishTime;
+	float tick_sec;
+	bool isPaused;
+};
+
+/*
+====================================================
+PhysicsThread
+Steps the scene at a fixed rate on its own thread and publishes the transforms after every batch of ticks.
+Only this thread touches the scene once started, the renderer reads the latest snapshot without locking
+and draws it one tick behind, between its previous and current transforms.
+The scene steps on a job system of its own: a wait helps with any queued job of its system, so on a shared one
+a render frame could end up running a whole serial task of the step.
+====================================================
+*/
+class PhysicsThread {
+public:
+	PhysicsThread() : tickRate( 60.0f ), maxStepsPerFrame( 4 ), scene( nullptr ), jobSystem( (int)std::thread::hardware_concurrency() ), isPaused( true ), numStepRequests( 0 ),
+		isResetRequested( false ), quit( false ), updateMicroseconds( 0 ), previousRevision( -1 ), shapesRevision( -1 ) {}
+	~PhysicsThread() { Stop(); }
+
+	void Start( Scene * physicsScene );
+	void Stop();
+
+	void SetPaused( const bool paused ) { isPaused.store( paused ); }
+	void RequestStep() { numStepRequests.fetch_add( 1 ); }	// One tick while paused
+	void RequestReset() { isResetRequested.store( true ); }
+
+	// Bodies come and go between ticks, requests made before a tick are all applied before it, despawns first.
+	// Spawned bodies should take their shapes from the scene's library, which any thread may add to
+	void RequestSpawn( const Body * bodies, const int num );
+	void RequestDespawn( const BodyHandle * handles, const int num );
+
+	// Render thread only
+	const TransformSnapshot & AcquireSnapshot() { return snapshots.Acquire(); }
+	float GetInterpolationAlpha( const TransformSnapshot & snapshot ) const;
+	int GetUpdateMicroseconds() const { return updateMicroseconds.load(); }
+
+	float tickRate;			// Set before Start
+	int maxStepsPerFrame;	// Time beyond this budget is dropped, a slow tick must not ask for even more ticks
+
+private:
+	PhysicsThread( const PhysicsThread & rhs );
+	const PhysicsThread & operator = ( const PhysicsThread & rhs );
+
+	void Loop();
+	bool ApplyBodyRequests();
+	void StepScene( const float dt_sec );
+	void SavePreviousTransforms();
+	void PublishSnapshot();
+
+	Scene * scene;
+	JobSystem jobSystem;
+	std::thread thread;
+
+	std::atomic< bool > isPaused;
+	std::atomic< int > numStepRequests;
+	std::atomic< bool > isResetRequested;
+	std::atomic< bool > quit;
+	std::atomic< int > updateMicroseconds;	// Time spent in the last batch of ticks
+
+	std::mutex requestsMutex;
+	std::vector< Body > spawnRequests;
+	std::vector< BodyHandle > despawnRequests;
+	std::vector< Body > spawnBodies;	// The requests being applied, swapped out so the lock is not held meanwhile
+	std::vector< BodyHandle > despawnHandles;
+
+	std::vector< Vec3 > previousPositions;
+	std::vector< Quat > previousOrientations;
+	int previousRevision;	// Bodies revision of the scene when the previous transforms were saved
+	std::vector< int > shapeIndices;
+	std::vector< BodyHandle > handles;
+	int shapesRevision;
+	TripleBuffer< TransformSnapshot > snapshots;
+};
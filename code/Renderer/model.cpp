@@ -385,6 +385,64 @@ void FillSphere(Model& model, const float radius) {
 	}
 }
 
+/*
+====================================================
+FillHeightGrid
+// Grid in the XY plane centered on the origin, z is the sampled height
+====================================================
+*/
+void FillHeightGrid(Model& model, const int numX, const int numY, const float cellSize, const float* heights) {
+	const float halfX = 0.5f * (numX - 1) * cellSize;
+	const float halfY = 0.5f * (numY - 1) * cellSize;
+
+	model.m_vertices.reserve(numX * numY);
+	for (int y = 0; y < numY; y++) {
+		for (int x = 0; x < numX; x++) {
+			// Central differences for the normal
+			const int x0 = (x > 0) ? x - 1 : x;
+			const int x1 = (x < numX - 1) ? x + 1 : x;
+			const int y0 = (y > 0) ? y - 1 : y;
+			const int y1 = (y < numY - 1) ? y + 1 : y;
+			const float dhdx = (heights[y * numX + x1] - heights[y * numX + x0]) / (float(x1 - x0) * cellSize);
+			const float dhdy = (heights[y1 * numX + x] - heights[y0 * numX + x]) / (float(y1 - y0) * cellSize);
+			Vec3 norm(-dhdx, -dhdy, 1.0f);
+			norm.Normalize();
+			Vec3 tang(1.0f, 0.0f, dhdx);
+			tang.Normalize();
+
+			vert_t vert;
+			memset(&vert, 0, sizeof(vert_t));
+			vert.xyz[0] = x * cellSize - halfX;
+			vert.xyz[1] = y * cellSize - halfY;
+			vert.xyz[2] = heights[y * numX + x];
+			vert.st[0] = (float)x / (float)(numX - 1);
+			vert.st[1] = (float)y / (float)(numY - 1);
+			Vec3ToByte4(norm, vert.norm);
+			Vec3ToByte4(tang, vert.tang);
+			model.m_vertices.push_back(vert);
+		}
+	}
+
+	model.m_indices.reserve((numX - 1) * (numY - 1) * 6);
+	for (int y = 0; y < numY - 1; y++) {
+		for (int x = 0; x < numX - 1; x++) {
+			const unsigned int i00 = y * numX + x;
+			const unsigned int i10 = y * numX + x + 1;
+			const unsigned int i01 = (y + 1) * numX + x;
+			const unsigned int i11 = (y + 1) * numX + x + 1;
+
+			// Same split as ShapeHeightfield::GetCellTriangles
+			model.m_indices.push_back(i00);
+			model.m_indices.push_back(i10);
+			model.m_indices.push_back(i11);
+
+			model.m_indices.push_back(i00);
+			model.m_indices.push_back(i11);
+			model.m_indices.push_back(i01);
+		}
+	}
+}
+
 /*
 ====================================================
 Model::BuildFromShape
@@ -407,6 +465,77 @@ bool Model::BuildFromShape(const Shape* shape) {
 			}
 		}
 	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_PLANE) {
+		const ShapePlane* shapePlane = (const ShapePlane*)shape;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		// Draw a finite tessellated patch of the infinite plane
+		const int numSamples = 33;
+		const float cellSize = 2.0f * shapePlane->renderExtent / (float)(numSamples - 1);
+		std::vector< float > heights(numSamples * numSamples, 0.0f);
+		FillHeightGrid(*this, numSamples, numSamples, cellSize, heights.data());
+
+		// Rotate the +Z grid onto the plane normal
+		Vec3 u;
+		Vec3 v;
+		shapePlane->normal.GetOrtho(u, v);
+		for (int i = 0; i < m_vertices.size(); i++) {
+			const Vec3 xyz = m_vertices[i].xyz;
+			const Vec3 pt = u * xyz.x + v * xyz.y + shapePlane->normal * xyz.z;
+			Vec3ToFloat3(pt, m_vertices[i].xyz);
+			Vec3ToByte4(shapePlane->normal, m_vertices[i].norm);
+			Vec3ToByte4(u, m_vertices[i].tang);
+		}
+	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_HEIGHTFIELD) {
+		const ShapeHeightfield* shapeHeightfield = (const ShapeHeightfield*)shape;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		FillHeightGrid(*this, shapeHeightfield->numX, shapeHeightfield->numY, shapeHeightfield->cellSize, shapeHeightfield->heights.data());
+	}
+	else if (shape->GetType() == Shape::ShapeType::SHAPE_TRIMESH) {
+		const ShapeTriMesh* shapeTriMesh = (const ShapeTriMesh*)shape;
+
+		m_vertices.clear();
+		m_indices.clear();
+
+		// Smoothed normals from the area weighted face normals
+		std::vector< Vec3 > normals(shapeTriMesh->vertices.size(), Vec3(0.0f));
+		for (int t = 0; t < shapeTriMesh->GetNumTriangles(); t++) {
+			const unsigned int* tri = &shapeTriMesh->indices[t * 3];
+			const Vec3& a = shapeTriMesh->vertices[tri[0]];
+			const Vec3& b = shapeTriMesh->vertices[tri[1]];
+			const Vec3& c = shapeTriMesh->vertices[tri[2]];
+			const Vec3 norm = (b - a).Cross(c - a);
+			normals[tri[0]] += norm;
+			normals[tri[1]] += norm;
+			normals[tri[2]] += norm;
+		}
+
+		m_vertices.reserve(shapeTriMesh->vertices.size());
+		for (int i = 0; i < shapeTriMesh->vertices.size(); i++) {
+			vert_t vert;
+			memset(&vert, 0, sizeof(vert_t));
+
+			Vec3ToFloat3(shapeTriMesh->vertices[i], vert.xyz);
+
+			Vec3 norm = normals[i];
+			norm.Normalize();
+			Vec3 tang;
+			Vec3 bitang;
+			norm.GetOrtho(tang, bitang);
+			Vec3ToByte4(norm, vert.norm);
+			Vec3ToByte4(tang, vert.tang);
+
+			m_vertices.push_back(vert);
+		}
+
+		m_indices = shapeTriMesh->indices;
+	}
 
 	/*
 	else if (shape->GetType() == Shape::ShapeType::SHAPE_BOX) {
@@ -4,7 +4,11 @@
 #include "Scene.h"
 #include "../Shape.h"
 #include "../Intersections.h"
+#include "../IntersectionsBatch.h"
+#include "../BodyBatch.h"
 #include "../Broadphase.h"
+#include <float.h>
+#include <algorithm>
 
 /*
 ========================================================================================================
@@ -14,29 +18,15 @@ Scene
 ========================================================================================================
 */
 
-/*
-====================================================
-Scene::~Scene
-====================================================
-*/
-Scene::~Scene() {
-	for ( int i = 0; i < bodies.size(); i++ ) {
-		delete bodies[ i ].shape;
-	}
-	bodies.clear();
-}
-
 /*
 ====================================================
 Scene::Reset
 ====================================================
 */
 void Scene::Reset() {
-	for ( int i = 0; i < bodies.size(); i++ ) {
-		delete bodies[ i ].shape;
-	}
-	bodies.clear();
+	ClearBodies();
 
+	// The shapes stay: Initialize finds the same ones in the library, so their indices don't change
 	Initialize();
 }
 
@@ -53,7 +43,7 @@ void Scene::Initialize() {
 	Body fast;
 	fast.position = Vec3(-3, 0, 3);
 	fast.orientation = Quat(0, 0, 0, 1);
-	fast.shape = new ShapeSphere(1.0f);
+	fast.shape = shapes.AddSphere(1.0f);
 	fast.inverseMass = 1.0f;
 	fast.elasticity = 0.5f;
 	fast.friction = 0.5f;
@@ -63,7 +53,7 @@ void Scene::Initialize() {
 	Body immobile;
 	immobile.position = Vec3(0, 0, 3);
 	immobile.orientation = Quat(0, 0, 0, 1);
-	immobile.shape = new ShapeSphere(1.0f);
+	immobile.shape = shapes.AddSphere(1.0f);
 	immobile.inverseMass = 1.0f;
 	immobile.elasticity = 0.5f;
 	immobile.friction = 0.5f;
@@ -73,7 +63,7 @@ void Scene::Initialize() {
 	Body earth;
 	earth.position = Vec3(0, 0, -1000);
 	earth.orientation = Quat(0, 0, 0, 1);
-	earth.shape = new ShapeSphere(1000.0f);
+	earth.shape = shapes.AddSphere(1000.0f);
 	earth.inverseMass = 0.0f;
 	earth.elasticity = 0.99f;
 	earth.friction = 0.5f;
@@ -92,7 +82,7 @@ void Scene::Initialize() {
 			float y = (j - 1) * radius * 1.5f;
 			body.position = Vec3(x, y, 10);
 			body.orientation = Quat(0, 0, 0, 1);
-			body.shape = new ShapeSphere(radius);
+			body.shape = shapes.AddSphere(radius);
 			body.inverseMass = 1.0f;
 			body.elasticity = 0.3f;
 			body.friction = 0.999f;
@@ -102,22 +92,23 @@ void Scene::Initialize() {
 	}
 
 	//---Rajoute le sol
-	for (int i = 0; i < 3; ++i)
+	const int numSamples = 32;
+	float heights[numSamples * numSamples];
+	for (int j = 0; j < numSamples; ++j)
 	{
-		for (int j = 0; j < 3; ++j)
+		for (int i = 0; i < numSamples; ++i)
 		{
-			float radius = 80.0f;
-			float x = (i - 1) * radius * 0.25f;
-			float y = (j - 1) * radius * 0.25f;
-			body.position = Vec3(x, y, -radius);
-			body.orientation = Quat(0, 0, 0, 1);
-			body.shape = new ShapeSphere(radius);
-			body.inverseMass = 0.0f;
-			body.elasticity = 0.99f;
-			body.friction = 0.5f;
-			bodies.push_back(body);
+			heights[j * numSamples + i] = 0.5f * sinf(i * 0.4f) * cosf(j * 0.4f);
 		}
 	}
+	body.position = Vec3(0, 0, 0);
+	body.orientation = Quat(0, 0, 0, 1);
+	body.shape = shapes.Add(new ShapeHeightfield(numSamples, numSamples, 1.0f, heights));
+	body.inverseMass = 0.0f;
+	body.elasticity = 0.99f;
+	body.friction = 0.5f;
+	body.linearVelocity.Zero();
+	bodies.push_back(body);
 
 	*/
 
@@ -125,16 +116,16 @@ void Scene::Initialize() {
 	Body cochonet;
 	cochonet.position = Vec3( 0, 0, 10 );
 	cochonet.orientation = Quat( 0, 0, 0, 1 );
-	cochonet.shape = new ShapeSphere( 0.5f );
+	cochonet.shape = shapes.AddSphere( 0.5f );
 	cochonet.inverseMass = 1.0f;
 	cochonet.elasticity = 0.5f;
 	cochonet.friction = 0.5f;
 	bodies.push_back(cochonet);
 	
 	Body earth;
-	earth.position = Vec3(0, 0, -6000);
+	earth.position = Vec3(0, 0, 0);
 	earth.orientation = Quat(0, 0, 0, 1);
-	earth.shape = new ShapeSphere(6000.0f);
+	earth.shape = shapes.AddPlane(Vec3(0, 0, 1));
 	earth.inverseMass = 0.0f;
 	earth.elasticity = 1.0f;
 	earth.friction = 0.5f;
@@ -144,18 +135,466 @@ void Scene::Initialize() {
 	// TODO: Add code
 }
 
+/*
+====================================================
+Scene::RegisterBodies
+Gives handles to the bodies pushed into the array by hand, and frees those of the bodies it lost
+====================================================
+*/
+void Scene::RegisterBodies() {
+	while ( bodySlots.size() > bodies.size() ) {
+		const int slot = bodySlots.back();
+		slotGenerations[ slot ]++;
+		slotBodies[ slot ] = -1;
+		freeSlots.push_back( slot );
+		bodySlots.pop_back();
+		bodiesRevision++;
+	}
+	while ( bodySlots.size() < bodies.size() ) {
+		int slot;
+		if ( freeSlots.empty() ) {
+			slot = (int)slotGenerations.size();
+			slotGenerations.push_back( 0 );
+			slotBodies.push_back( -1 );
+		} else {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		slotBodies[ slot ] = (int)bodySlots.size();
+		bodySlots.push_back( slot );
+		bodiesRevision++;
+	}
+}
+
+/*
+====================================================
+Scene::AddBody
+====================================================
+*/
+BodyHandle Scene::AddBody( const Body & body ) {
+	BodyHandle handle;
+	SpawnBodies( &body, 1, &handle );
+	return handle;
+}
+
+/*
+====================================================
+Scene::RemoveBody
+====================================================
+*/
+void Scene::RemoveBody( const BodyHandle handle ) {
+	DespawnBodies( &handle, 1 );
+}
+
+/*
+====================================================
+Scene::SpawnBodies
+The new bodies go at the end of the array, the broadphase sorts them in at the next step
+====================================================
+*/
+void Scene::SpawnBodies( const Body * newBodies, const int num, BodyHandle * handles ) {
+	RegisterBodies();
+	const int first = (int)bodies.size();
+	bodies.insert( bodies.end(), newBodies, newBodies + num );
+	RegisterBodies();
+
+	if ( nullptr != handles ) {
+		for ( int i = 0; i < num; i++ ) {
+			handles[ i ] = GetHandle( first + i );
+		}
+	}
+}
+
+/*
+====================================================
+Scene::DespawnBodies
+Every hole is filled by the last living body, then the manifolds and the broadphase follow the moves in a single pass
+====================================================
+*/
+void Scene::DespawnBodies( const BodyHandle * handles, const int num ) {
+	RegisterBodies();
+	const int numBodies = (int)bodies.size();
+	bodyRemap.resize( numBodies );
+	for ( int i = 0; i < numBodies; i++ ) {
+		bodyRemap[ i ] = i;
+	}
+
+	int numRemoved = 0;
+	for ( int i = 0; i < num; i++ ) {
+		const int index = GetBodyIndex( handles[ i ] );
+		if ( index < 0 ) {
+			continue;
+		}
+		bodyRemap[ index ] = -1;
+		slotGenerations[ handles[ i ].slot ]++;
+		slotBodies[ handles[ i ].slot ] = -1;
+		freeSlots.push_back( handles[ i ].slot );
+		numRemoved++;
+	}
+	if ( 0 == numRemoved ) {
+		return;
+	}
+
+	// What rested on a removed body has to fall
+	for ( int i = 0; i < manifolds.manifolds.size(); i++ ) {
+		const Manifold & manifold = manifolds.manifolds[ i ];
+		if ( bodyRemap[ manifold.bodyA ] < 0 ) {
+			bodies[ manifold.bodyB ].Wake();
+		}
+		if ( bodyRemap[ manifold.bodyB ] < 0 ) {
+			bodies[ manifold.bodyA ].Wake();
+		}
+	}
+
+	// The broadphase has to know every body before they move
+	sweepAndPrune.AddBodies( bodies.data(), numBodies );
+
+	int end = numBodies;
+	for ( int i = 0; i < end; i++ ) {
+		if ( bodyRemap[ i ] >= 0 ) {
+			continue;
+		}
+		do {
+			end--;
+		} while ( end > i && bodyRemap[ end ] < 0 );
+		if ( end == i ) {
+			break;
+		}
+		bodies[ i ] = bodies[ end ];
+		bodySlots[ i ] = bodySlots[ end ];
+		slotBodies[ bodySlots[ i ] ] = i;
+		bodyRemap[ end ] = i;
+	}
+	bodies.erase( bodies.begin() + end, bodies.end() );
+	bodySlots.resize( end );
+
+	manifolds.RemapBodies( bodyRemap.data() );
+	sweepAndPrune.RemapBodies( bodyRemap.data(), end );
+	bodiesRevision++;
+}
+
+/*
+====================================================
+Scene::ClearBodies
+Removes every body, their handles stay invalid
+====================================================
+*/
+void Scene::ClearBodies() {
+	bodies.clear();
+	RegisterBodies();
+	manifolds.Clear();
+	sweepAndPrune.Clear();
+	bodiesRevision++;
+}
+
+/*
+====================================================
+Scene::GetBodyIndex
+====================================================
+*/
+int Scene::GetBodyIndex( const BodyHandle handle ) const {
+	if ( handle.slot < 0 || handle.slot >= slotGenerations.size() || slotGenerations[ handle.slot ] != handle.generation ) {
+		return -1;
+	}
+	return slotBodies[ handle.slot ];
+}
+
+/*
+====================================================
+Scene::GetBody
+====================================================
+*/
+Body * Scene::GetBody( const BodyHandle handle ) {
+	const int index = GetBodyIndex( handle );
+	return ( index >= 0 ) ? &bodies[ index ] : nullptr;
+}
+
+/*
+====================================================
+Scene::GetHandle
+====================================================
+*/
+BodyHandle Scene::GetHandle( const int bodyIndex ) {
+	RegisterBodies();
+	const int slot = bodySlots[ bodyIndex ];
+	return BodyHandle( slot, slotGenerations[ slot ] );
+}
+
+/*
+====================================================
+BuildNeighbours
+Broadphase pairs as one list of neighbours per body (offsets into neighbours, numBodies + 1 entries)
+====================================================
+*/
+static void BuildNeighbours( const std::vector<CollisionPair> & pairs, const int numBodies, FrameArena & arena, int * & offsets, int * & neighbours ) {
+	offsets = arena.AllocateZeroedArray<int>( numBodies + 1 );
+	for ( int i = 0; i < pairs.size(); i++ ) {
+		offsets[ pairs[ i ].a + 1 ]++;
+		offsets[ pairs[ i ].b + 1 ]++;
+	}
+	for ( int i = 0; i < numBodies; i++ ) {
+		offsets[ i + 1 ] += offsets[ i ];
+	}
+	neighbours = arena.AllocateArray<int>( offsets[ numBodies ] );
+	int * cursor = arena.AllocateArray<int>( numBodies );
+	for ( int i = 0; i < numBodies; i++ ) {
+		cursor[ i ] = offsets[ i ];
+	}
+	for ( int i = 0; i < pairs.size(); i++ ) {
+		neighbours[ cursor[ pairs[ i ].a ]++ ] = pairs[ i ].b;
+		neighbours[ cursor[ pairs[ i ].b ]++ ] = pairs[ i ].a;
+	}
+}
+
+/*
+====================================================
+SortPairs
+Canonical order of the broadphase pairs: lower body first, then by body index
+====================================================
+*/
+static void SortPairs( std::vector<CollisionPair> & pairs ) {
+	for ( int i = 0; i < pairs.size(); i++ ) {
+		if ( pairs[ i ].a > pairs[ i ].b ) {
+			std::swap( pairs[ i ].a, pairs[ i ].b );
+		}
+	}
+	std::sort( pairs.begin(), pairs.end(), []( const CollisionPair & lhs, const CollisionPair & rhs ) {
+		return ( lhs.a != rhs.a ) ? ( lhs.a < rhs.a ) : ( lhs.b < rhs.b );
+	} );
+}
+
+/*
+====================================================
+IsApproaching
+====================================================
+*/
+static bool IsApproaching( const Contact & contact ) {
+	const Body * a = contact.a;
+	const Body * b = contact.b;
+	const Vec3 velA = a->linearVelocity + a->angularVelocity.Cross( contact.ptOnAWorldSpace - a->GetCenterOfMassWorldSpace() );
+	const Vec3 velB = b->linearVelocity + b->angularVelocity.Cross( contact.ptOnBWorldSpace - b->GetCenterOfMassWorldSpace() );
+	return ( velA - velB ).Dot( contact.normal ) < 0.0f;
+}
+
+/*
+====================================================
+PredictImpact
+Tests a pair again from time to the end of the step, after one of its bodies changed velocity
+====================================================
+*/
+static void PredictImpact( std::vector<Body> & bodies, TimeOfImpactQueue & queue, const int indexA, const int indexB, const float time, const float dt_sec ) {
+	Body & bodyA = bodies[ indexA ];
+	Body & bodyB = bodies[ indexB ];
+	if ( bodyA.IsResting() && bodyB.IsResting() ) {
+		return;
+	}
+
+	// No event is left before time, so both bodies can be moved there
+	queue.AdvanceBody( indexA, time );
+	queue.AdvanceBody( indexB, time );
+
+	Contact contact;
+	if ( !Intersections::Intersect( bodyA, bodyB, dt_sec - time, contact ) ) {
+		return;
+	}
+	// Touching but already moving apart (typically the pair that was just resolved)
+	if ( contact.timeOfImpact == 0.0f && !IsApproaching( contact ) ) {
+		return;
+	}
+	contact.timeOfImpact += time;
+	queue.Push( contact );
+}
+
 /*
 ====================================================
 Scene::Update
 ====================================================
 */
 void Scene::Update( const float dt_sec ) {
-	// TODO: Add code
+	numSubsteps = ChooseSubsteps( dt_sec );
+	for ( int i = 0; i < numSubsteps; i++ ) {
+		Step( dt_sec / (float)numSubsteps );
+	}
+}
 
+/*
+====================================================
+Scene::ChooseSubsteps
+====================================================
+*/
+int Scene::ChooseSubsteps( const float dt_sec ) const {
+	float motion = 0.0f;
+	for ( int i = 0; i < bodies.size(); i++ ) {
+		const Body & body = bodies[ i ];
+		if ( body.IsResting() ) {
+			continue;
+		}
+		const Bounds & bounds = body.shape->GetLocalBounds();
+		const float minSize = fminf( bounds.WidthX(), fminf( bounds.WidthY(), bounds.WidthZ() ) );
+		const float maxSize = fmaxf( bounds.WidthX(), fmaxf( bounds.WidthY(), bounds.WidthZ() ) );
+		if ( minSize <= 0.0f ) {
+			continue;
+		}
+		// Fastest point of the body: its center plus the spin at its far end
+		const float speed = body.linearVelocity.GetMagnitude() + body.angularVelocity.GetMagnitude() * maxSize * 0.5f;
+		motion = fmaxf( motion, speed * dt_sec / minSize );
+	}
+
+	float penetration = 0.0f;
+	for ( int i = 0; i < manifolds.manifolds.size(); i++ ) {
+		const Manifold & manifold = manifolds.manifolds[ i ];
+		if ( bodies[ manifold.bodyA ].IsResting() && bodies[ manifold.bodyB ].IsResting() ) {
+			continue;
+		}
+		for ( int c = 0; c < manifold.numContacts; c++ ) {
+			penetration = fmaxf( penetration, -manifold.points[ c ].separationDistance - contactSolver.positionCorrection.penetrationSlop );
+		}
+	}
+
+	int substeps = minSubsteps;
+	substeps = std::max( substeps, (int)ceilf( motion / maxSubstepMotion ) );
+	substeps = std::max( substeps, (int)ceilf( penetration / maxSubstepPenetration ) );
+	substeps = std::max( substeps, (int)ceilf( solverResidual / maxSubstepResidual ) );
+	return std::min( substeps, maxSubsteps );
+}
+
+/*
+====================================================
+Scene::BuildStepGraph
+Every phase of the step is a task of the graph, the loops over bodies, pairs and islands run in parallel.
+The broadphase needs the velocities after gravity, the refresh of the manifolds needs nothing.
+The tasks allocating from frameArena run alone: the broadphase waits for the refresh of the manifolds,
+the static geometry waits for the broadphase.
+Tasks only capture the scene: what changes from one step to the next is read from its members
+====================================================
+*/
+void Scene::BuildStepGraph() {
+	graphBodiesPerTask = bodiesPerTask;
+	graphPairsPerTask = pairsPerTask;
+	graphIslandsPerTask = islandsPerTask;
+
+	auto countBodies = [ this ]() { return (int)bodies.size(); };
+	auto countIslands = [ this ]() { return islands.GetNumIslands(); };
+
+	stepGraph.Clear();
+	const int gravity = stepGraph.AddParallelFor( countBodies, bodiesPerTask, [ this ]( const int begin, const int end ) {
+		ApplyGravity( begin, end, stepDt );
+	} );
+	const int refreshManifolds = stepGraph.AddTask( [ this ]() {
+		// Refresh the persistent contacts from last step and drop the stale ones
+		manifolds.RemoveExpired( bodies.data() );
+	} );
+	const int broadphase = stepGraph.AddTask( [ this ]() {
+		frameArena.TakeOwnership();
+		FindCollisionPairs();
+	}, { gravity, refreshManifolds } );
+	const int narrowphase = stepGraph.AddParallelFor( [ this ]() { return (int)collisionPairs.size(); }, pairsPerTask, [ this ]( const int begin, const int end ) {
+		NarrowPhase( begin, end, stepDt );
+	}, { broadphase } );
+	const int staticPhase = stepGraph.AddParallelFor( countBodies, bodiesPerTask, [ this ]( const int begin, const int end ) {
+		CollideStaticGeometry( begin, end, stepDt );
+	}, { broadphase } );
+	const int buildIslands = stepGraph.AddTask( [ this ]() {
+		frameArena.TakeOwnership();
+		BuildIslands();
+	}, { narrowphase, staticPhase } );
+	const int solveIslands = stepGraph.AddParallelFor( countIslands, islandsPerTask, [ this ]( const int begin, const int end ) {
+		SolveIslands( begin, end, stepDt );
+	}, { buildIslands } );
+	const int solveLargeIslands = stepGraph.AddTask( [ this ]() {
+		SolveLargeIslands( stepDt );
+	}, { solveIslands } );
+	const int timeOfImpact = stepGraph.AddTask( [ this ]() {
+		frameArena.TakeOwnership();
+		ResolveTimeOfImpacts( impactContacts, numImpactContacts, stepDt );
+	}, { solveLargeIslands } );
+	const int integrate = stepGraph.AddParallelFor( countBodies, bodiesPerTask, [ this ]( const int begin, const int end ) {
+		IntegrateBodies( begin, end, stepDt );
+	}, { timeOfImpact } );
+	stepGraph.AddParallelFor( countIslands, islandsPerTask, [ this ]( const int begin, const int end ) {
+		for ( int i = begin; i < end; i++ ) {
+			UpdateIslandSleep( i, stepDt );
+		}
+	}, { integrate } );
+}
+
+/*
+====================================================
+Scene::RunStepPhases
+The phases of the step graph in their order, each loop over its whole range, without going through the graph
+====================================================
+*/
+void Scene::RunStepPhases() {
+	const int numBodies = (int)bodies.size();
+	ApplyGravity( 0, numBodies, stepDt );
+	manifolds.RemoveExpired( bodies.data() );
+	FindCollisionPairs();
+	NarrowPhase( 0, (int)collisionPairs.size(), stepDt );
+	CollideStaticGeometry( 0, numBodies, stepDt );
+	BuildIslands();
+	SolveIslands( 0, islands.GetNumIslands(), stepDt );
+	SolveLargeIslands( stepDt );
+	ResolveTimeOfImpacts( impactContacts, numImpactContacts, stepDt );
+	IntegrateBodies( 0, numBodies, stepDt );
+	for ( int i = 0; i < islands.GetNumIslands(); i++ ) {
+		UpdateIslandSleep( i, stepDt );
+	}
+}
+
+/*
+====================================================
+Scene::Step
+====================================================
+*/
+void Scene::Step( const float dt_sec ) {
+	frameArena.TakeOwnership();
+	RegisterBodies();
+	solverResidual = 0.0f;
+	contactSolver.jobSystem = jobSystem;
+	contactSolver.isDeterministic = isDeterministic;
+
+	// Static geometry is not in the broadphase, it is tested against every dynamic body
+	staticGeometry.clear();
+	for ( int i = 0; i < bodies.size(); i++ ) {
+		if ( bodies[ i ].shape->IsStaticGeometry() ) {
+			staticGeometry.push_back( i );
+		}
+	}
+	numStaticSlots = (int)( bodies.size() * staticGeometry.size() );
+	staticHits = frameArena.AllocateZeroedArray<char>( numStaticSlots );
+	staticContacts = frameArena.AllocateArray<Contact>( numStaticSlots );
+	impactContacts = nullptr;
+	numImpactContacts = 0;
+	stepDt = dt_sec;
+
+	if ( nullptr == jobSystem || jobSystem->GetNumThreads() == 1 ) {
+		RunStepPhases();
+	} else {
+		if ( stepGraph.IsEmpty() || graphBodiesPerTask != bodiesPerTask || graphPairsPerTask != pairsPerTask || graphIslandsPerTask != islandsPerTask ) {
+			BuildStepGraph();
+		}
+		stepGraph.Run( jobSystem );
+		frameArena.TakeOwnership();
+	}
+	frameArena.Reset();
+
+	for ( int i = 0; i < islandResiduals.size(); i++ ) {
+		solverResidual = fmaxf( solverResidual, islandResiduals[ i ] );
+	}
+}
+
+/*
+====================================================
+Scene::ApplyGravity
+====================================================
+*/
+void Scene::ApplyGravity( const int begin, const int end, const float dt_sec ) {
 	//Gravit 
-	for (int i = 0; i < bodies.size(); ++i) 
+	for (int i = begin; i < end; ++i) 
 	{
 		Body& body = bodies[i];
+		if (body.IsResting())
+			continue;
 		float mass = 1.0f / body.inverseMass;
 		// Gravity needs to be an impulse I
 		// I == dp, so F == dp/dt <=> dp = F * dt
@@ -163,66 +602,511 @@ void Scene::Update( const float dt_sec ) {
 		Vec3 impulseGravity = Vec3(0, 0, -10) * mass * dt_sec;	//Crer impulse de gravit
 		body.ApplyImpulseLinear(impulseGravity);	//Applique l'impulse
 	}
+}
 
-	
+/*
+====================================================
+Scene::FindCollisionPairs
+Broadphase pairs of the step, with an uninitialized contact and a cleared hit flag each
+====================================================
+*/
+void Scene::FindCollisionPairs() {
+	collisionPairs.clear();
+	sweepAndPrune.Update( bodies.data(), (int)bodies.size(), collisionPairs, stepDt, frameArena );
+	if ( isDeterministic ) {
+		SortPairs( collisionPairs );
+	}
+	pairHits = frameArena.AllocateZeroedArray<char>( (int)collisionPairs.size() );
+	pairContacts = frameArena.AllocateArray<Contact>( (int)collisionPairs.size() );
+}
 
-	// Broadphase
-	std::vector<CollisionPair> collisionPairs;
-	BroadPhase(bodies.data(), bodies.size(), collisionPairs, dt_sec);
-	// Collision checks (Narrow phase)
-	int numContacts = 0;
-	const int maxContacts = bodies.size() * bodies.size();
-	Contact* contacts = (Contact*)alloca(sizeof(Contact) * maxContacts);
-	for (int i = 0; i < collisionPairs.size(); ++i)
+/*
+====================================================
+Scene::NarrowPhase
+Tests a range of broadphase pairs, the hits are kept in the slot of their pair
+====================================================
+*/
+void Scene::NarrowPhase( const int begin, const int end, const float dt_sec ) {
+	// Sphere-sphere pairs are tested a batch at a time with SIMD, the other shapes one by one
+	SphereSphereBatch batch;
+	SphereSphereBatchResult batchResult;
+	int batchPairs[SphereSphereBatch::MAX_PAIRS];
+	batch.count = 0;
+	auto flushBatch = [&]()
+	{
+		if (batch.count == 0)
+		{
+			return;
+		}
+		SphereSphereDynamicBatch(batch, dt_sec, batchResult);
+		for (int k = 0; k < batch.count; ++k)
+		{
+			if ((batchResult.hitMask & (1u << k)) == 0)
+			{
+				continue;
+			}
+			const int i = batchPairs[k];
+			const CollisionPair& pair = collisionPairs[i];
+			Contact& contact = pairContacts[i];
+			contact.timeOfImpact = batchResult.timeOfImpact[k];
+			contact.ptOnAWorldSpace = Vec3(batchResult.ptOnAx[k], batchResult.ptOnAy[k], batchResult.ptOnAz[k]);
+			contact.ptOnBWorldSpace = Vec3(batchResult.ptOnBx[k], batchResult.ptOnBy[k], batchResult.ptOnBz[k]);
+			Intersections::BuildSphereSphereContact(bodies[pair.a], bodies[pair.b], contact);
+			pairHits[i] = 1;
+		}
+		batch.count = 0;
+	};
+
+	for (int i = begin; i < end; ++i)
 	{
 		const CollisionPair& pair = collisionPairs[i];
 		Body& bodyA = bodies[pair.a];
 		Body& bodyB = bodies[pair.b];
-		if (bodyA.inverseMass == 0.0f && bodyB.inverseMass == 0.0f)
+		// Nothing moves between two sleeping or static bodies
+		if (bodyA.IsResting() && bodyB.IsResting())
+			continue;
+
+		if (bodyA.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE && bodyB.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE)
+		{
+			const int k = batch.count;
+			batch.posAx[k] = bodyA.position.x;
+			batch.posAy[k] = bodyA.position.y;
+			batch.posAz[k] = bodyA.position.z;
+			batch.posBx[k] = bodyB.position.x;
+			batch.posBy[k] = bodyB.position.y;
+			batch.posBz[k] = bodyB.position.z;
+			batch.velAx[k] = bodyA.linearVelocity.x;
+			batch.velAy[k] = bodyA.linearVelocity.y;
+			batch.velAz[k] = bodyA.linearVelocity.z;
+			batch.velBx[k] = bodyB.linearVelocity.x;
+			batch.velBy[k] = bodyB.linearVelocity.y;
+			batch.velBz[k] = bodyB.linearVelocity.z;
+			batch.radiusA[k] = static_cast<const ShapeSphere*>(bodyA.shape)->radius;
+			batch.radiusB[k] = static_cast<const ShapeSphere*>(bodyB.shape)->radius;
+			batchPairs[k] = i;
+			batch.count++;
+			if (batch.count == SphereSphereBatch::MAX_PAIRS)
+			{
+				flushBatch();
+			}
 			continue;
-		Contact contact;
-		if (Intersections::Intersect(bodyA, bodyB, dt_sec, contact))
+		}
+
+		if (Intersections::Intersect(bodyA, bodyB, dt_sec, pairContacts[i]))
+		{
+			pairHits[i] = 1;
+		}
+	}
+	flushBatch();
+}
+
+/*
+====================================================
+Scene::CollideStaticGeometry
+====================================================
+*/
+void Scene::CollideStaticGeometry( const int begin, const int end, const float dt_sec ) {
+	const int numStatic = (int)staticGeometry.size();
+	for (int j = begin; j < end; ++j)
+	{
+		Body& body = bodies[j];
+		if (body.IsResting())
+			continue;
+		for (int g = 0; g < numStatic; ++g)
+		{
+			const int slot = j * numStatic + g;
+			if (Intersections::Intersect(body, bodies[staticGeometry[g]], dt_sec, staticContacts[slot]))
+			{
+				staticHits[slot] = 1;
+			}
+		}
+	}
+}
+
+/*
+====================================================
+Scene::GatherContacts
+Sorts the hits of the parallel tests in pair order: touching ones go to the manifolds, the others wait for their time of impact
+====================================================
+*/
+void Scene::GatherContacts( Contact * contacts, int & numContacts ) {
+	auto addContact = [&](const Contact& contact)
+	{
+		if (contact.timeOfImpact == 0.0f)
+		{
+			// Already touching: resting contact, kept in a manifold
+			manifolds.AddContact(contact, bodies.data());
+		}
+		else
 		{
 			contacts[numContacts] = contact;
 			++numContacts;
 		}
+	};
+
+	for (int i = 0; i < collisionPairs.size(); ++i)
+	{
+		if (pairHits[i])
+		{
+			addContact(pairContacts[i]);
+		}
+	}
+	const int numStaticSlots = (int)(bodies.size() * staticGeometry.size());
+	for (int i = 0; i < numStaticSlots; ++i)
+	{
+		if (staticHits[i])
+		{
+			addContact(staticContacts[i]);
+		}
+	}
+}
+
+/*
+====================================================
+Scene::BuildIslands
+Islands: bodies coupled by this step's contacts, each one is solved on its own
+====================================================
+*/
+void Scene::BuildIslands() {
+	impactContacts = frameArena.AllocateArray<Contact>( (int)collisionPairs.size() + numStaticSlots );
+	GatherContacts( impactContacts, numImpactContacts );
+	islands.Build( bodies.data(), (int)bodies.size(), manifolds, impactContacts, numImpactContacts );
+	PrepareIslandSolvers();
+}
+
+/*
+====================================================
+Scene::PrepareIslandSolvers
+One solver per range of islands, with the settings of contactSolver
+====================================================
+*/
+void Scene::PrepareIslandSolvers() {
+	const int grain = ( islandsPerTask > 0 ) ? islandsPerTask : 1;
+	const int numRanges = std::max( 1, ( islands.GetNumIslands() + grain - 1 ) / grain );
+	if ( islandSolvers.size() < numRanges ) {
+		islandSolvers.resize( numRanges );
+	}
+	for ( int i = 0; i < numRanges; i++ ) {
+		islandSolvers[ i ].CopySettings( contactSolver );
+	}
+	islandResiduals.assign( numRanges, 0.0f );
+}
+
+/*
+====================================================
+Scene::WakeIsland
+A sleeping island touched by an awake body wakes up as a whole, a fully sleeping one stays asleep
+====================================================
+*/
+bool Scene::WakeIsland( const Island & island ) {
+	bool isAwake = false;
+	for (int b = 0; b < island.numBodies; ++b)
+	{
+		isAwake = isAwake || bodies[island.bodies[b]].isAwake;
+	}
+	if (!isAwake)
+		return false;
+	for (int b = 0; b < island.numBodies; ++b)
+	{
+		if (!bodies[island.bodies[b]].isAwake)
+		{
+			bodies[island.bodies[b]].Wake();
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+Scene::SolveIsland
+Resting contacts: start from last step's impulses, then resolve. Returns the solver residual
+====================================================
+*/
+float Scene::SolveIsland( ContactSolver & solver, const int islandIndex, const float dt_sec ) {
+	const Island island = islands.GetIsland(islandIndex);
+	if (solverMode != SolverMode::SOLVER_SINGLE_PASS)
+	{
+		if (solverMode == SolverMode::SOLVER_SEQUENTIAL_IMPULSE)
+		{
+			solver.Solve(manifolds, islands, islandIndex, bodies.data(), dt_sec);
+		}
+		else
+		{
+			solver.SolveBlockPGS(manifolds, islands, islandIndex, bodies.data(), dt_sec);
+		}
+
+		// The solvers skip Body::ApplyImpulseAngular, the spin limit of the single pass applies once at the end
+		for (int b = 0; b < island.numBodies; ++b)
+		{
+			bodies[island.bodies[b]].ClampAngularVelocity();
+		}
+		return solver.GetResidual();
 	}
 
-	// Sort times of impact
-	if (numContacts > 1)
+	for (int m = 0; m < island.numManifolds; ++m)
+	{
+		manifolds.manifolds[island.manifolds[m]].WarmStart(bodies.data());
+	}
+	for (int m = 0; m < island.numManifolds; ++m)
 	{
-		qsort(contacts, numContacts, sizeof(Contact), Contact::CompareContact);
+		manifolds.manifolds[island.manifolds[m]].ResolveContacts(bodies.data(), solver.positionCorrection, dt_sec);
+	}
+	return 0.0f;
+}
+
+/*
+====================================================
+Scene::IsLargeIsland
+Large islands are solved one at a time, each one spread over the threads by graph coloring
+====================================================
+*/
+bool Scene::IsLargeIsland( const Island & island ) const {
+	const bool hasThreads = jobSystem != nullptr && jobSystem->GetNumThreads() > 1;
+	return solverMode == SolverMode::SOLVER_SEQUENTIAL_IMPULSE && ( hasThreads || isDeterministic ) &&
+		island.numManifolds >= contactSolver.minParallelManifolds;
+}
+
+/*
+====================================================
+Scene::SolveIslands
+Islands share no dynamic body: a range of islands is solved with its own solver, in parallel with the other ranges
+====================================================
+*/
+void Scene::SolveIslands( const int begin, const int end, const float dt_sec ) {
+	const int grain = ( islandsPerTask > 0 ) ? islandsPerTask : 1;
+	const int range = begin / grain;
+	ContactSolver & solver = islandSolvers[ range ];
+	for ( int i = begin; i < end; i++ ) {
+		const Island island = islands.GetIsland( i );
+		if ( IsLargeIsland( island ) || !WakeIsland( island ) || island.numManifolds == 0 ) {
+			continue;
+		}
+		islandResiduals[ range ] = fmaxf( islandResiduals[ range ], SolveIsland( solver, i, dt_sec ) );
+	}
+}
+
+/*
+====================================================
+Scene::SolveLargeIslands
+====================================================
+*/
+void Scene::SolveLargeIslands( const float dt_sec ) {
+	for ( int i = 0; i < islands.GetNumIslands(); i++ ) {
+		const Island island = islands.GetIsland( i );
+		if ( !IsLargeIsland( island ) || !WakeIsland( island ) ) {
+			continue;
+		}
+		solverResidual = fmaxf( solverResidual, SolveIsland( contactSolver, i, dt_sec ) );
 	}
+}
 
-	// Contact resolve in order
-	float accumulatedTime = 0.0f;
+/*
+====================================================
+Scene::ResolveTimeOfImpacts
+Continuous collisions, earliest impact first.
+Resolving an impact changes the velocity of its two bodies: their other events become stale
+and only their broadphase pairs are tested again over the rest of the step
+====================================================
+*/
+void Scene::ResolveTimeOfImpacts( const Contact * contacts, const int numContacts, const float dt_sec ) {
+	timeOfImpactQueue.Begin(bodies.data(), (int)bodies.size());
 	for (int i = 0; i < numContacts; ++i)
 	{
-		Contact& contact = contacts[i];
-		const float dt = contact.timeOfImpact - accumulatedTime;
+		timeOfImpactQueue.Push(contacts[i]);
+	}
+	if (numContacts == 0)
+		return;
+
+	int* neighbourOffsets = nullptr;
+	int* neighbours = nullptr;
+	BuildNeighbours(collisionPairs, (int)bodies.size(), frameArena, neighbourOffsets, neighbours);
+
+	int numEvents = 0;
+	Contact contact;
+	while (numEvents < maxTimeOfImpactEvents && timeOfImpactQueue.Pop(contact))
+	{
 		Body* bodyA = contact.a;
 		Body* bodyB = contact.b;
 		// Skip body par with infinite mass
 		if (bodyA->inverseMass == 0.0f && bodyB->inverseMass == 0.0f)
 			continue;
-		// Position update
-		for (int j = 0; j < bodies.size(); ++j) {
-			bodies[j].Update(dt);
+
+		// Position update of the two bodies only
+		const float time = contact.timeOfImpact;
+		const int indexA = timeOfImpactQueue.GetBodyIndex(bodyA);
+		const int indexB = timeOfImpactQueue.GetBodyIndex(bodyB);
+		timeOfImpactQueue.AdvanceBody(indexA, time);
+		timeOfImpactQueue.AdvanceBody(indexB, time);
+		Contact::ResolveContact(contact, contactSolver.positionCorrection, dt_sec);
+		timeOfImpactQueue.Invalidate(indexA);
+		timeOfImpactQueue.Invalidate(indexB);
+		++numEvents;
+
+		// New trajectories: predict their next impacts
+		const int changed[2] = { indexA, indexB };
+		for (int k = 0; k < 2; ++k)
+		{
+			const int index = changed[k];
+			if (bodies[index].inverseMass == 0.0f)
+				continue;
+			for (int n = neighbourOffsets[index]; n < neighbourOffsets[index + 1]; ++n)
+			{
+				// The pair of both bodies was already tested from A
+				if (k == 1 && neighbours[n] == indexA)
+					continue;
+				PredictImpact(bodies, timeOfImpactQueue, index, neighbours[n], time, dt_sec);
+			}
+			for (int n = 0; n < staticGeometry.size(); ++n)
+			{
+				PredictImpact(bodies, timeOfImpactQueue, index, staticGeometry[n], time, dt_sec);
+			}
 		}
-		Contact::ResolveContact(contact);
-		accumulatedTime += dt;
 	}
+}
 
-	// Other physics behavirous, outside collisions.
-	// Update the positions for the rest of this frame's time.
-	const float timeRemaining = dt_sec - accumulatedTime;
-	if (timeRemaining > 0.0f)
-	{
-		for (int i = 0; i < bodies.size(); ++i) {
-			bodies[i].Update(timeRemaining);
+/*
+====================================================
+Scene::IntegrateBodies
+Other physics behavirous, outside collisions.
+Update the positions for the rest of this frame's time, then push the penetrating bodies apart
+====================================================
+*/
+void Scene::IntegrateBodies( const int begin, const int end, const float dt_sec ) {
+	// Spherical bodies go through the batched kernel, the others are integrated one by one
+	BodyBatch batch;
+	int batchBodies[ BodyBatch::MAX_BODIES ];
+	batch.count = 0;
+
+	auto flushBatch = [ & ]() {
+		IntegrateBodiesBatch( batch );
+		for ( int b = 0; b < batch.count; b++ ) {
+			Body & body = bodies[ batchBodies[ b ] ];
+			body.position = Vec3( batch.positionX[ b ], batch.positionY[ b ], batch.positionZ[ b ] );
+			body.orientation = Quat( batch.orientationX[ b ], batch.orientationY[ b ], batch.orientationZ[ b ], batch.orientationW[ b ] );
+			body.ApplyPseudoVelocity( dt_sec );
+		}
+		batch.count = 0;
+	};
+
+	for ( int i = begin; i < end; i++ ) {
+		Body & body = bodies[ i ];
+		if ( !body.isAwake ) {
+			continue;
+		}
+		if ( !body.shape->IsSpherical() ) {
+			timeOfImpactQueue.AdvanceBody( i, dt_sec );
+			body.ApplyPseudoVelocity( dt_sec );
+			continue;
 		}
+
+		// What is left of the step after the time of impact phase, nothing when a late impact already took it there
+		const float dt = timeOfImpactQueue.TakeTimeTo( i, dt_sec );
+		if ( dt <= 0.0f ) {
+			body.ApplyPseudoVelocity( dt_sec );
+			continue;
+		}
+
+		const int b = batch.count++;
+		batchBodies[ b ] = i;
+		batch.positionX[ b ] = body.position.x;
+		batch.positionY[ b ] = body.position.y;
+		batch.positionZ[ b ] = body.position.z;
+		batch.orientationW[ b ] = body.orientation.w;
+		batch.orientationX[ b ] = body.orientation.x;
+		batch.orientationY[ b ] = body.orientation.y;
+		batch.orientationZ[ b ] = body.orientation.z;
+		batch.linearVelocityX[ b ] = body.linearVelocity.x;
+		batch.linearVelocityY[ b ] = body.linearVelocity.y;
+		batch.linearVelocityZ[ b ] = body.linearVelocity.z;
+		batch.angularVelocityX[ b ] = body.angularVelocity.x;
+		batch.angularVelocityY[ b ] = body.angularVelocity.y;
+		batch.angularVelocityZ[ b ] = body.angularVelocity.z;
+		batch.dt[ b ] = dt;
+		if ( batch.count == BodyBatch::MAX_BODIES ) {
+			flushBatch();
+		}
+	}
+	if ( batch.count > 0 ) {
+		flushBatch();
 	}
+}
 
+/*
+====================================================
+Scene::UpdateIslandSleep
+An island falls asleep once all its bodies have stayed slow for timeToSleep
+====================================================
+*/
+void Scene::UpdateIslandSleep( const int islandIndex, const float dt_sec ) {
+	const Island island = islands.GetIsland( islandIndex );
+	float islandSleepTime = FLT_MAX;
+	for ( int b = 0; b < island.numBodies; b++ ) {
+		Body & body = bodies[ island.bodies[ b ] ];
+		if ( !body.isAwake ) {
+			continue;
+		}
+		const bool isSlow = body.linearVelocity.GetLengthSqr() < sleepLinearSpeed * sleepLinearSpeed &&
+							body.angularVelocity.GetLengthSqr() < sleepAngularSpeed * sleepAngularSpeed;
+		body.sleepTime = isSlow ? body.sleepTime + dt_sec : 0.0f;
+		islandSleepTime = ( body.sleepTime < islandSleepTime ) ? body.sleepTime : islandSleepTime;
+	}
+
+	if ( islandSleepTime >= timeToSleep && islandSleepTime != FLT_MAX ) {
+		for ( int b = 0; b < island.numBodies; b++ ) {
+			bodies[ island.bodies[ b ] ].Sleep();
+		}
+	}
+}
+
+/*
+====================================================
+HashBytes
+FNV-1a, 64 bits
+====================================================
+*/
+static unsigned long long HashBytes( unsigned long long hash, const void * data, const int size ) {
+	const unsigned char * bytes = (const unsigned char *)data;
+	for ( int i = 0; i < size; i++ ) {
+		hash ^= bytes[ i ];
+		hash *= 1099511628211ull;
+	}
+	return hash;
 }
 
+/*
+====================================================
+Scene::ComputeStateHash
+Hash of the state every next step depends on, to compare two runs step by step
+====================================================
+*/
+unsigned long long Scene::ComputeStateHash() const {
+	unsigned long long hash = 14695981039346656037ull;
+	for ( int i = 0; i < bodies.size(); i++ ) {
+		const Body & body = bodies[ i ];
+		hash = HashBytes( hash, &body.position, sizeof( body.position ) );
+		hash = HashBytes( hash, &body.orientation, sizeof( body.orientation ) );
+		hash = HashBytes( hash, &body.linearVelocity, sizeof( body.linearVelocity ) );
+		hash = HashBytes( hash, &body.angularVelocity, sizeof( body.angularVelocity ) );
+		hash = HashBytes( hash, &body.isAwake, sizeof( body.isAwake ) );
+		hash = HashBytes( hash, &body.sleepTime, sizeof( body.sleepTime ) );
+	}
 
+	// Persistent contacts warm start the next solve
+	for ( int i = 0; i < manifolds.manifolds.size(); i++ ) {
+		const Manifold & manifold = manifolds.manifolds[ i ];
+		const ContactAnchor * anchors = manifolds.GetAnchors( i );
+		hash = HashBytes( hash, &manifold.bodyA, sizeof( manifold.bodyA ) );
+		hash = HashBytes( hash, &manifold.bodyB, sizeof( manifold.bodyB ) );
+		for ( int c = 0; c < manifold.numContacts; c++ ) {
+			const ContactPoint & point = manifold.points[ c ];
+			hash = HashBytes( hash, &anchors[ c ].ptOnALocalSpace, sizeof( anchors[ c ].ptOnALocalSpace ) );
+			hash = HashBytes( hash, &anchors[ c ].ptOnBLocalSpace, sizeof( anchors[ c ].ptOnBLocalSpace ) );
+			hash = HashBytes( hash, &point.normal, sizeof( point.normal ) );
+			hash = HashBytes( hash, &point.separationDistance, sizeof( point.separationDistance ) );
+			hash = HashBytes( hash, &point.normalImpulse, sizeof( point.normalImpulse ) );
+			hash = HashBytes( hash, &point.frictionImpulse, sizeof( point.frictionImpulse ) );
+		}
+	}
+	hash = HashBytes( hash, &numSubsteps, sizeof( numSubsteps ) );
+	return hash;
+}
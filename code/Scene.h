@@ -5,6 +5,31 @@
 #include <vector>
 
 #include "../Body.h"
+#include "../Manifold.h"
+#include "../ContactSolver.h"
+#include "Threading/TaskGraph.h"
+#include "Memory/FrameArena.h"
+#include "../TimeOfImpact.h"
+#include "../Broadphase.h"
+#include "../ShapeLibrary.h"
+
+/*
+====================================================
+BodyHandle
+Names a body for its whole life: its index in Scene::bodies changes as other bodies are removed, its handle doesn't.
+The slot of a removed body is reused with a new generation, so old handles to it stay invalid
+====================================================
+*/
+struct BodyHandle {
+	BodyHandle() : slot( -1 ), generation( 0 ) {}
+	BodyHandle( const int slotIndex, const int slotGeneration ) : slot( slotIndex ), generation( slotGeneration ) {}
+
+	bool operator == ( const BodyHandle & rhs ) const { return slot == rhs.slot && generation == rhs.generation; }
+	bool operator != ( const BodyHandle & rhs ) const { return !( *this == rhs ); }
+
+	int slot;
+	int generation;
+};
 
 /*
 ====================================================
@@ -13,13 +38,131 @@ Scene
 */
 class Scene {
 public:
-	Scene() { bodies.reserve( 128 ); }
-	~Scene();
+	// Worlds with few bodies can start with a smaller frameArena, it grows to what a step needs
+	explicit Scene( const size_t frameArenaSize = 64 * 1024 ) : jobSystem( nullptr ), bodiesPerTask( 64 ), pairsPerTask( 32 ), islandsPerTask( 8 ),
+		solverMode( SolverMode::SOLVER_SEQUENTIAL_IMPULSE ), maxTimeOfImpactEvents( 256 ),
+		sleepLinearSpeed( 0.05f ), sleepAngularSpeed( 0.05f ), timeToSleep( 0.5f ),
+		minSubsteps( 1 ), maxSubsteps( 4 ), maxSubstepMotion( 0.25f ), maxSubstepPenetration( 0.02f ), maxSubstepResidual( 0.5f ),
+		numSubsteps( 1 ), solverResidual( 0.0f ), isDeterministic( false ), frameArena( frameArenaSize ), bodiesRevision( 0 ),
+		stepDt( 0.0f ), graphBodiesPerTask( 0 ), graphPairsPerTask( 0 ), graphIslandsPerTask( 0 ),
+		pairContacts( nullptr ), pairHits( nullptr ), staticContacts( nullptr ), staticHits( nullptr ),
+		impactContacts( nullptr ), numImpactContacts( 0 ), numStaticSlots( 0 ) {
+		bodies.reserve( 128 );
+	}
 
 	void Reset();
 	void Initialize();
 	void Update( const float dt_sec );	
+	void Step( const float dt_sec );
+	int ChooseSubsteps( const float dt_sec ) const;
+	unsigned long long ComputeStateHash() const;
+
+	// Bodies come and go between steps, never during one. The array stays dense: a removed body is replaced
+	// by the last one, so indices in bodies change but handles don't. Bodies pushed into the array directly get
+	// their handles the first time they are needed
+	BodyHandle AddBody( const Body & body );
+	void RemoveBody( const BodyHandle handle );
+	void SpawnBodies( const Body * newBodies, const int num, BodyHandle * handles );	// handles may be nullptr
+	void DespawnBodies( const BodyHandle * handles, const int num );	// Invalid handles are skipped
+	void ClearBodies();
+
+	bool IsValid( const BodyHandle handle ) const { return GetBodyIndex( handle ) >= 0; }
+	int GetBodyIndex( const BodyHandle handle ) const;	// -1 once the body is removed
+	Body * GetBody( const BodyHandle handle );
+	BodyHandle GetHandle( const int bodyIndex );
+
+	// Changes whenever bodies are added, removed or moved in the array
+	int GetBodiesRevision() const { return bodiesRevision; }
 
 	std::vector<Body> bodies;
+	ShapeLibrary shapes;	// Bodies added by hand take their shapes from here, or from a library that outlives the scene
+	ManifoldCollector manifolds;
+
+	// The phases of a step are a task graph run on the job system: nullptr calls them in order on the calling thread
+	JobSystem * jobSystem;
+	int bodiesPerTask;	// Grain of the parallel loops of a step
+	int pairsPerTask;
+	int islandsPerTask;
+
+	IslandBuilder islands;
+	SolverMode solverMode;
+	ContactSolver contactSolver;	// contactSolver.iterations sets the iteration count
+
+	TimeOfImpactQueue timeOfImpactQueue;
+	int maxTimeOfImpactEvents;	// Impacts resolved per step at most, the later ones are ignored
+
+	float sleepLinearSpeed;		// Below both speeds for timeToSleep seconds, a body may sleep
+	float sleepAngularSpeed;
+	float timeToSleep;
+
+	// Update splits its time in substeps, from what the previous step measured:
+	// the fastest body against its size, the deepest contact and the solver residual.
+	// Each metric asks for enough substeps to get back under its limit
+	int minSubsteps;
+	int maxSubsteps;
+	float maxSubstepMotion;			// Distance moved in one substep, as a fraction of the body's smallest size
+	float maxSubstepPenetration;	// Beyond the slop
+	float maxSubstepResidual;		// m/s
+	int numSubsteps;				// Chosen by the last Update
+	float solverResidual;			// Largest ContactSolver residual of the last step
+
+	// Steps are bitwise identical across runs and thread counts: the broadphase pairs are sorted by body index
+	// and large islands are always solved by colors. Builds only agree when compiled with the same floating point model
+	bool isDeterministic;
+
+	// Transient data of a step, emptied when the step ends. Its high water mark tells the memory a step needs
+	FrameArena frameArena;
+
+
+private:
+	void ApplyGravity( const int begin, const int end, const float dt_sec );
+	void FindCollisionPairs();
+	void NarrowPhase( const int begin, const int end, const float dt_sec );
+	void CollideStaticGeometry( const int begin, const int end, const float dt_sec );
+	void GatherContacts( Contact * contacts, int & numContacts );
+	void BuildIslands();
+	void PrepareIslandSolvers();
+	bool WakeIsland( const Island & island );
+	float SolveIsland( ContactSolver & solver, const int islandIndex, const float dt_sec );
+	bool IsLargeIsland( const Island & island ) const;
+	void SolveIslands( const int begin, const int end, const float dt_sec );
+	void SolveLargeIslands( const float dt_sec );
+	void ResolveTimeOfImpacts( const Contact * contacts, const int numContacts, const float dt_sec );
+	void IntegrateBodies( const int begin, const int end, const float dt_sec );
+	void UpdateIslandSleep( const int islandIndex, const float dt_sec );
+
+	// Built by the first step run on threads, its tasks read the step from stepDt. Built again if a grain changes
+	void BuildStepGraph();
+	void RunStepPhases();
+	TaskGraph stepGraph;
+	float stepDt;
+	int graphBodiesPerTask;
+	int graphPairsPerTask;
+	int graphIslandsPerTask;
+
+	// Per step data, kept to reuse the allocations
+	std::vector<CollisionPair> collisionPairs;
+	std::vector<int> staticGeometry;
+	SweepAndPrune sweepAndPrune;
+
+	// Handles: a slot per handle, with its generation and the body it names (-1 when free)
+	void RegisterBodies();
+	std::vector<int> slotGenerations;
+	std::vector<int> slotBodies;
+	std::vector<int> bodySlots;	// Slot of each body
+	std::vector<int> freeSlots;
+	std::vector<int> bodyRemap;
+	int bodiesRevision;
+
+	// In frameArena, valid during a step only
+	Contact * pairContacts;		// One slot per broadphase pair
+	char * pairHits;
+	Contact * staticContacts;	// One slot per body and static geometry
+	char * staticHits;
+	Contact * impactContacts;	// Contacts not touching yet, for the time of impact phase: at most one per pair and static slot
+	int numImpactContacts;
+	int numStaticSlots;
+	std::vector<ContactSolver> islandSolvers;	// One per range of islands, ranges are solved in parallel
+	std::vector<float> islandResiduals;
 };
 
@@ -0,0 +1,179 @@
+//
+//	JobSystem.cpp
+//
+#include "JobSystem.h"
+
+// Worker threads remember which system and deque they belong to
+static thread_local const JobSystem * tlsJobSystem = nullptr;
+static thread_local int tlsQueueIndex = 0;
+
+/*
+====================================================
+JobSystem::JobSystem
+====================================================
+*/
+JobSystem::JobSystem( const int numThreads ) :
+numQueued( 0 ),
+quit( false ) {
+	const int num = ( numThreads > 1 ) ? numThreads : 1;
+	for ( int i = 0; i < num; i++ ) {
+		queues.push_back( std::unique_ptr< WorkerQueue >( new WorkerQueue ) );
+	}
+	for ( int i = 1; i < num; i++ ) {
+		workers.push_back( std::thread( &JobSystem::WorkerLoop, this, i ) );
+	}
+}
+
+/*
+====================================================
+JobSystem::~JobSystem
+====================================================
+*/
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard< std::mutex > lock( sleepMutex );
+		quit = true;
+	}
+	sleepCondition.notify_all();
+	for ( int i = 0; i < workers.size(); i++ ) {
+		workers[ i ].join();
+	}
+}
+
+/*
+====================================================
+JobSystem::GetQueueIndex
+====================================================
+*/
+int JobSystem::GetQueueIndex() const {
+	return ( tlsJobSystem == this ) ? tlsQueueIndex : 0;
+}
+
+/*
+====================================================
+JobSystem::Run
+Queues the job on the deque of the calling thread
+====================================================
+*/
+void JobSystem::Run( const JobFunction & func, Counter * counter ) {
+	counter->count.fetch_add( 1 );
+
+	if ( workers.empty() ) {
+		func();
+		counter->count.fetch_sub( 1 );
+		return;
+	}
+
+	WorkerQueue & queue = *queues[ GetQueueIndex() ];
+	{
+		std::lock_guard< std::mutex > lock( queue.mutex );
+		Job job;
+		job.func = func;
+		job.counter = counter;
+		queue.jobs.push_back( job );
+	}
+	numQueued.fetch_add( 1 );
+
+	// Taking the lock orders the push before a worker that is about to sleep checks numQueued
+	{
+		std::lock_guard< std::mutex > lock( sleepMutex );
+	}
+	sleepCondition.notify_one();
+}
+
+/*
+====================================================
+JobSystem::Wait
+====================================================
+*/
+void JobSystem::Wait( Counter * counter ) {
+	const int queueIndex = GetQueueIndex();
+	while ( counter->count.load( std::memory_order_acquire ) > 0 ) {
+		if ( !TryRunJob( queueIndex ) ) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+/*
+====================================================
+JobSystem::ParallelFor
+The calling thread runs the first range, then helps with the others
+====================================================
+*/
+void JobSystem::ParallelFor( const int count, const int grain, const RangeFunction & func ) {
+	const int rangeSize = ( grain > 0 ) ? grain : 1;
+	if ( workers.empty() || count <= rangeSize ) {
+		if ( count > 0 ) {
+			func( 0, count );
+		}
+		return;
+	}
+
+	Counter counter;
+	for ( int begin = rangeSize; begin < count; begin += rangeSize ) {
+		const int end = ( begin + rangeSize < count ) ? begin + rangeSize : count;
+		Run( [ &func, begin, end ]() { func( begin, end ); }, &counter );
+	}
+	func( 0, rangeSize );
+	Wait( &counter );
+}
+
+/*
+====================================================
+JobSystem::TryRunJob
+Newest job of our own deque first, otherwise the oldest job of another deque
+====================================================
+*/
+bool JobSystem::TryRunJob( const int queueIndex ) {
+	Job job;
+	bool found = false;
+	{
+		WorkerQueue & queue = *queues[ queueIndex ];
+		std::lock_guard< std::mutex > lock( queue.mutex );
+		if ( !queue.jobs.empty() ) {
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			found = true;
+		}
+	}
+	for ( int i = 1; i < queues.size() && !found; i++ ) {
+		WorkerQueue & victim = *queues[ ( queueIndex + i ) % queues.size() ];
+		std::lock_guard< std::mutex > lock( victim.mutex );
+		if ( !victim.jobs.empty() ) {
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			found = true;
+		}
+	}
+	if ( !found ) {
+		return false;
+	}
+
+	numQueued.fetch_sub( 1 );
+	job.func();
+	job.counter->count.fetch_sub( 1, std::memory_order_release );
+	return true;
+}
+
+/*
+====================================================
+JobSystem::WorkerLoop
+====================================================
+*/
+void JobSystem::WorkerLoop( const int queueIndex ) {
+	tlsJobSystem = this;
+	tlsQueueIndex = queueIndex;
+
+	while ( true ) {
+		if ( TryRunJob( queueIndex ) ) {
+			continue;
+		}
+
+		std::unique_lock< std::mutex > lock( sleepMutex );
+		sleepCondition.wait( lock, [ this ]() { return quit || numQueued.load() > 0; } );
+		if ( quit ) {
+			return;
+		}
+	}
+}
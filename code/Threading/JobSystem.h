@@ -0,0 +1,69 @@
+//
+//	JobSystem.h
+//
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+====================================================
+JobSystem
+Work stealing scheduler. The physics and the renderer each have their own.
+Every worker owns a deque: it pushes and pops its own jobs at the back, idle workers steal from the front of the others.
+Threads outside the system (the main thread) share the first deque.
+Waiting never blocks a thread, it runs jobs until its counter drops to zero.
+====================================================
+*/
+class JobSystem {
+public:
+	typedef std::function< void() > JobFunction;
+	typedef std::function< void( const int begin, const int end ) > RangeFunction;
+
+	// Jobs still running in a group
+	struct Counter {
+		Counter() : count( 0 ) {}
+		std::atomic< int > count;
+	};
+
+	explicit JobSystem( const int numThreads );
+	~JobSystem();
+
+	void Run( const JobFunction & func, Counter * counter );
+	void Wait( Counter * counter );
+
+	// Calls func on consecutive ranges of at most grain indices covering [ 0, count ), returns when all are done
+	void ParallelFor( const int count, const int grain, const RangeFunction & func );
+	int GetNumThreads() const { return (int)queues.size(); }
+
+private:
+	JobSystem( const JobSystem & rhs );
+	const JobSystem & operator = ( const JobSystem & rhs );
+
+	struct Job {
+		JobFunction func;
+		Counter * counter;
+	};
+
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque< Job > jobs;
+	};
+
+	int GetQueueIndex() const;
+	bool TryRunJob( const int queueIndex );
+	void WorkerLoop( const int queueIndex );
+
+	std::vector< std::unique_ptr< WorkerQueue > > queues;
+	std::vector< std::thread > workers;
+
+	std::atomic< int > numQueued;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	bool quit;
+};
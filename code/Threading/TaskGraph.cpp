@@ -0,0 +1,157 @@
+//
+//	TaskGraph.cpp
+//
+#include "TaskGraph.h"
+#include <assert.h>
+
+/*
+====================================================
+TaskGraph::AddTask
+====================================================
+*/
+int TaskGraph::AddTask( const TaskFunction & func, std::initializer_list< int > dependencies ) {
+	Task task;
+	task.func = func;
+	task.grain = 0;
+	task.numDependencies = 0;
+	tasks.push_back( task );
+	return AddDependencies( (int)tasks.size() - 1, dependencies );
+}
+
+/*
+====================================================
+TaskGraph::AddParallelFor
+====================================================
+*/
+int TaskGraph::AddParallelFor( const CountFunction & count, const int grain, const JobSystem::RangeFunction & func, std::initializer_list< int > dependencies ) {
+	Task task;
+	task.count = count;
+	task.range = func;
+	task.grain = ( grain > 0 ) ? grain : 1;
+	task.numDependencies = 0;
+	tasks.push_back( task );
+	return AddDependencies( (int)tasks.size() - 1, dependencies );
+}
+
+/*
+====================================================
+TaskGraph::AddDependencies
+====================================================
+*/
+int TaskGraph::AddDependencies( const int task, std::initializer_list< int > dependencies ) {
+	for ( const int dependency : dependencies ) {
+		assert( dependency >= 0 && dependency < task );
+		tasks[ dependency ].successors.push_back( task );
+		tasks[ task ].numDependencies++;
+	}
+	return task;
+}
+
+/*
+====================================================
+TaskGraph::Run
+====================================================
+*/
+void TaskGraph::Run( JobSystem * system ) {
+	if ( nullptr == system || system->GetNumThreads() == 1 ) {
+		for ( int i = 0; i < tasks.size(); i++ ) {
+			const Task & task = tasks[ i ];
+			if ( task.func ) {
+				task.func();
+				continue;
+			}
+			const int count = task.count();
+			if ( count > 0 ) {
+				task.range( 0, count );
+			}
+		}
+		return;
+	}
+
+	JobSystem::Counter graphCounter;
+	jobSystem = system;
+	counter = &graphCounter;
+	if ( numCounters < tasks.size() ) {
+		numCounters = (int)tasks.size();
+		remainingDependencies.reset( new std::atomic< int >[ numCounters ] );
+		remainingRanges.reset( new std::atomic< int >[ numCounters ] );
+	}
+	for ( int i = 0; i < tasks.size(); i++ ) {
+		remainingDependencies[ i ].store( tasks[ i ].numDependencies );
+		remainingRanges[ i ].store( 0 );
+	}
+
+	for ( int i = 0; i < tasks.size(); i++ ) {
+		if ( 0 == tasks[ i ].numDependencies ) {
+			Submit( i );
+		}
+	}
+
+	// Successors are queued by the job that finishes their last dependency, before that job ends:
+	// the counter only reaches zero once the whole graph is done
+	jobSystem->Wait( counter );
+	jobSystem = nullptr;
+	counter = nullptr;
+}
+
+/*
+====================================================
+TaskGraph::Submit
+====================================================
+*/
+void TaskGraph::Submit( const int task ) {
+	jobSystem->Run( [ this, task ]() { StartTask( task ); }, counter );
+}
+
+/*
+====================================================
+TaskGraph::StartTask
+A parallel loop queues all its ranges but the first one, the last range to end finishes the task
+====================================================
+*/
+void TaskGraph::StartTask( const int task ) {
+	const Task & desc = tasks[ task ];
+	if ( desc.func ) {
+		desc.func();
+		FinishTask( task );
+		return;
+	}
+
+	const int count = desc.count();
+	if ( count <= 0 ) {
+		FinishTask( task );
+		return;
+	}
+
+	const int numRanges = ( count + desc.grain - 1 ) / desc.grain;
+	remainingRanges[ task ].store( numRanges );
+	for ( int r = 0; r < numRanges; r++ ) {
+		const int begin = r * desc.grain;
+		const int end = ( begin + desc.grain < count ) ? begin + desc.grain : count;
+		auto runRange = [ this, task, begin, end ]() {
+			tasks[ task ].range( begin, end );
+			if ( remainingRanges[ task ].fetch_sub( 1 ) == 1 ) {
+				FinishTask( task );
+			}
+		};
+		if ( r + 1 < numRanges ) {
+			jobSystem->Run( runRange, counter );
+		} else {
+			runRange();
+		}
+	}
+}
+
+/*
+====================================================
+TaskGraph::FinishTask
+====================================================
+*/
+void TaskGraph::FinishTask( const int task ) {
+	const std::vector< int > & successors = tasks[ task ].successors;
+	for ( int i = 0; i < successors.size(); i++ ) {
+		if ( remainingDependencies[ successors[ i ] ].fetch_sub( 1 ) == 1 ) {
+			Submit( successors[ i ] );
+		}
+	}
+}
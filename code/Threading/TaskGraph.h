@@ -0,0 +1,54 @@
+//
+//	TaskGraph.h
+//
+#pragma once
+#include <initializer_list>
+#include "JobSystem.h"
+
+/*
+====================================================
+TaskGraph
+Tasks and parallel loops that start once the tasks they depend on are done.
+A task can only depend on tasks added before it, so the order of addition is a valid serial order.
+The size of a parallel loop is asked when it starts: it may come from an earlier task.
+====================================================
+*/
+class TaskGraph {
+public:
+	typedef std::function< void() > TaskFunction;
+	typedef std::function< int() > CountFunction;
+
+	TaskGraph() : jobSystem( nullptr ), counter( nullptr ), numCounters( 0 ) {}
+
+	// A graph is meant to be built once and run many times: tasks read what changes between runs from their owner
+	void Clear() { tasks.clear(); }
+	bool IsEmpty() const { return tasks.empty(); }
+	int AddTask( const TaskFunction & func, std::initializer_list< int > dependencies = {} );
+	int AddParallelFor( const CountFunction & count, const int grain, const JobSystem::RangeFunction & func, std::initializer_list< int > dependencies = {} );
+
+	// Runs every task and returns once all are done. Without job system they run in order on the calling thread
+	void Run( JobSystem * jobSystem );
+
+private:
+	struct Task {
+		TaskFunction func;
+		CountFunction count;
+		JobSystem::RangeFunction range;
+		int grain;
+		int numDependencies;
+		std::vector< int > successors;
+	};
+
+	int AddDependencies( const int task, std::initializer_list< int > dependencies );
+	void Submit( const int task );
+	void StartTask( const int task );
+	void FinishTask( const int task );
+
+	std::vector< Task > tasks;
+
+	JobSystem * jobSystem;
+	JobSystem::Counter * counter;
+	std::unique_ptr< std::atomic< int >[] > remainingDependencies;	// numCounters each, kept across runs
+	std::unique_ptr< std::atomic< int >[] > remainingRanges;
+	int numCounters;
+};
@@ -0,0 +1,47 @@
+//
+//	TripleBuffer.h
+//
+#pragma once
+#include <atomic>
+
+/*
+====================================================
+TripleBuffer
+One writer thread and one reader thread exchange buffers without locks.
+The writer fills its buffer and publishes it, the reader takes the latest published one.
+Neither ever waits: the third buffer is the one in between.
+====================================================
+*/
+template< typename T >
+class TripleBuffer {
+public:
+	TripleBuffer() : writeIndex( 0 ), middle( 1 ), readIndex( 2 ) {}
+
+	// Writer side
+	T & GetWriteBuffer() { return buffers[ writeIndex ]; }
+	void Publish() {
+		const int previous = middle.exchange( writeIndex | FRESH_BIT, std::memory_order_acq_rel );
+		writeIndex = previous & INDEX_MASK;
+	}
+
+	// Reader side: the latest published buffer, the same one until a newer one is published
+	const T & Acquire() {
+		if ( middle.load( std::memory_order_relaxed ) & FRESH_BIT ) {
+			const int previous = middle.exchange( readIndex, std::memory_order_acq_rel );
+			readIndex = previous & INDEX_MASK;
+		}
+		return buffers[ readIndex ];
+	}
+
+private:
+	TripleBuffer( const TripleBuffer & rhs );
+	const TripleBuffer & operator = ( const TripleBuffer & rhs );
+
+	static const int INDEX_MASK = 3;
+	static const int FRESH_BIT = 4;	// The middle buffer was published after the reader last took one
+
+	T buffers[ 3 ];
+	int writeIndex;
+	std::atomic< int > middle;
+	int readIndex;
+};
@@ -0,0 +1,119 @@
+//
+//  WorldBatch.cpp
+//
+#include "WorldBatch.h"
+
+/*
+====================================================
+WorldBatch::~WorldBatch
+====================================================
+*/
+WorldBatch::~WorldBatch() {
+	Clear();
+}
+
+/*
+====================================================
+WorldBatch::AddWorld
+====================================================
+*/
+int WorldBatch::AddWorld( const std::vector< Body > & bodies ) {
+	// Worlds are many and small: their arenas start small and grow to what a step needs
+	Scene * world = new Scene( 4 * 1024 );
+	world->SpawnBodies( bodies.data(), (int)bodies.size(), nullptr );
+	worlds.push_back( world );
+	initialBodies.push_back( bodies );
+	return (int)worlds.size() - 1;
+}
+
+/*
+====================================================
+WorldBatch::ResetWorld
+====================================================
+*/
+void WorldBatch::ResetWorld( const int worldIndex ) {
+	Scene * world = worlds[ worldIndex ];
+	world->ClearBodies();
+	world->SpawnBodies( initialBodies[ worldIndex ].data(), (int)initialBodies[ worldIndex ].size(), nullptr );
+	world->numSubsteps = 1;
+	world->solverResidual = 0.0f;
+}
+
+/*
+====================================================
+WorldBatch::Clear
+Removes the worlds, the shapes stay for the next ones
+====================================================
+*/
+void WorldBatch::Clear() {
+	for ( int i = 0; i < worlds.size(); i++ ) {
+		delete worlds[ i ];
+	}
+	worlds.clear();
+	initialBodies.clear();
+	worldOffsets.clear();
+	positions.clear();
+	orientations.clear();
+	linearVelocities.clear();
+	angularVelocities.clear();
+}
+
+/*
+====================================================
+WorldBatch::Step
+====================================================
+*/
+void WorldBatch::Step( const float dt_sec ) {
+	auto stepWorlds = [ this, dt_sec ]( const int begin, const int end ) {
+		for ( int i = begin; i < end; i++ ) {
+			worlds[ i ]->Update( dt_sec );
+		}
+	};
+
+	if ( nullptr == jobSystem ) {
+		stepWorlds( 0, (int)worlds.size() );
+	} else {
+		jobSystem->ParallelFor( (int)worlds.size(), worldsPerTask, stepWorlds );
+	}
+
+	GatherStates();
+}
+
+/*
+====================================================
+WorldBatch::GatherStates
+====================================================
+*/
+void WorldBatch::GatherStates() {
+	const int numWorlds = (int)worlds.size();
+	worldOffsets.resize( numWorlds + 1 );
+	worldOffsets[ 0 ] = 0;
+	for ( int i = 0; i < numWorlds; i++ ) {
+		worldOffsets[ i + 1 ] = worldOffsets[ i ] + (int)worlds[ i ]->bodies.size();
+	}
+
+	const int numBodies = worldOffsets[ numWorlds ];
+	positions.resize( numBodies );
+	orientations.resize( numBodies );
+	linearVelocities.resize( numBodies );
+	angularVelocities.resize( numBodies );
+
+	auto gatherWorlds = [ this ]( const int begin, const int end ) {
+		for ( int i = begin; i < end; i++ ) {
+			const std::vector< Body > & bodies = worlds[ i ]->bodies;
+			const int offset = worldOffsets[ i ];
+			for ( int j = 0; j < bodies.size(); j++ ) {
+				positions[ offset + j ] = bodies[ j ].position;
+				orientations[ offset + j ] = bodies[ j ].orientation;
+				linearVelocities[ offset + j ] = bodies[ j ].linearVelocity;
+				angularVelocities[ offset + j ] = bodies[ j ].angularVelocity;
+			}
+		}
+	};
+
+	if ( nullptr == jobSystem ) {
+		gatherWorlds( 0, numWorlds );
+	} else {
+		jobSystem->ParallelFor( numWorlds, worldsPerTask, gatherWorlds );
+	}
+}
@@ -0,0 +1,58 @@
+//
+//  WorldBatch.h
+//
+#pragma once
+#include <vector>
+
+#include "Scene.h"
+
+/*
+====================================================
+WorldBatch
+Many independent scenes stepped together, for parameter sweeps.
+The worlds share the shapes of the batch, which owns them, and step in lockstep:
+every Step advances all of them by the same time, whole worlds are spread over the job system.
+After a step the state of every body of every world is in contiguous arrays, world after world.
+====================================================
+*/
+class WorldBatch {
+public:
+	WorldBatch() : jobSystem( nullptr ), worldsPerTask( 4 ) {}
+	~WorldBatch();
+
+	// The bodies are copied into a new world, they are also what ResetWorld restores
+	int AddWorld( const std::vector< Body > & bodies );
+	void ResetWorld( const int worldIndex );
+	void Clear();
+
+	int GetNumWorlds() const { return (int)worlds.size(); }
+	Scene & GetWorld( const int worldIndex ) { return *worlds[ worldIndex ]; }
+	const Scene & GetWorld( const int worldIndex ) const { return *worlds[ worldIndex ]; }
+
+	void Step( const float dt_sec );
+
+	// Fills the state arrays from the worlds, Step does it after every step
+	void GatherStates();
+
+	// Worlds are stepped in parallel, each on a single thread: their own jobSystem should stay nullptr.
+	// Small worlds are grouped so a job amortizes its cost over several of them
+	JobSystem * jobSystem;
+	int worldsPerTask;
+
+	// The bodies of every world take their shapes from here
+	ShapeLibrary shapes;
+
+	// The bodies of world w are [ worldOffsets[ w ], worldOffsets[ w + 1 ] ) in the state arrays
+	std::vector< int > worldOffsets;
+	std::vector< Vec3 > positions;
+	std::vector< Quat > orientations;
+	std::vector< Vec3 > linearVelocities;
+	std::vector< Vec3 > angularVelocities;
+
+private:
+	WorldBatch( const WorldBatch & rhs );
+	const WorldBatch & operator = ( const WorldBatch & rhs );
+
+	std::vector< Scene * > worlds;
+	std::vector< std::vector< Body > > initialBodies;
+};
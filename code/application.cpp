@@ -76,14 +76,7 @@ void Application::Initialize() {
 	scene->Initialize();
 	scene->Reset();
 
-	m_models.reserve( scene->bodies.size() );
-	for ( int i = 0; i < scene->bodies.size(); i++ ) {
-		Model * model = new Model();
-		model->BuildFromShape( scene->bodies[ i ].shape );
-		model->MakeVBO( &deviceContext );
-
-		m_models.push_back( model );
-	}
+	UpdateModels();
 
 	m_mousePosition = Vec2( 0, 0 );
 	m_cameraPositionTheta = acosf( -1.0f ) / 2.0f;
@@ -92,7 +85,8 @@ void Application::Initialize() {
 	m_cameraFocusPoint = Vec3( 0, 0, 3 );
 
 	m_isPaused = true;
-	m_stepFrame = false;
+	m_physicsThread.SetPaused( m_isPaused );
+	m_physicsThread.Start( scene );
 }
 
 /*
@@ -213,9 +207,11 @@ bool Application::InitializeVulkan() {
 	}
 
 	//
-	//	Uniform Buffer
+	//	Uniform Buffer: the camera and the shadow camera, then the matrices of the bodies
 	//
-	m_uniformBuffer.Allocate( &deviceContext, NULL, sizeof( float ) * 16 * 4 * 128, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT );
+	const int cameraByteSize = deviceContext.GetAligendUniformByteOffset( sizeof( float ) * 16 * 4 );
+	const int bodyByteSize = deviceContext.GetAligendUniformByteOffset( sizeof( Mat4 ) );
+	m_uniformBuffer.Allocate( &deviceContext, NULL, cameraByteSize * 2 + bodyByteSize * MAX_DRAWN_BODIES, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT );
 
 	//
 	//	Offscreen rendering
@@ -278,6 +274,9 @@ Application::Cleanup
 ====================================================
 */
 void Application::Cleanup() {
+	// The scene belongs to the physics thread until it stops
+	m_physicsThread.Stop();
+
 	CleanupOffscreen( &deviceContext );
 
 	m_copyShader.Cleanup( &deviceContext );
@@ -429,14 +428,76 @@ Application::Keyboard
 */
 void Application::Keyboard( int key, int scancode, int action, int modifiers ) {
 	if ( GLFW_KEY_R == key && GLFW_RELEASE == action ) {
-		scene->Reset();
+		m_physicsThread.RequestReset();
 	}
 	if ( GLFW_KEY_T == key && GLFW_RELEASE == action ) {
 		m_isPaused = !m_isPaused;
+		m_physicsThread.SetPaused( m_isPaused );
+	}
+	if ( GLFW_KEY_Y == key && ( GLFW_PRESS == action || GLFW_REPEAT == action ) && m_isPaused ) {
+		m_physicsThread.RequestStep();
 	}
-	if ( GLFW_KEY_Y == key && ( GLFW_PRESS == action || GLFW_REPEAT == action ) ) {
-		m_stepFrame = m_isPaused && !m_stepFrame;
+	if ( GLFW_KEY_F == key && ( GLFW_PRESS == action || GLFW_REPEAT == action ) ) {
+		FireProjectile();
+	}
+	if ( GLFW_KEY_G == key && GLFW_RELEASE == action ) {
+		ClearProjectiles();
+	}
+}
+
+/*
+====================================================
+Application::GetCameraPosition
+====================================================
+*/
+Vec3 Application::GetCameraPosition() const {
+	Vec3 camPos;
+	camPos.x = cosf( m_cameraPositionPhi ) * sinf( m_cameraPositionTheta );
+	camPos.y = sinf( m_cameraPositionPhi ) * sinf( m_cameraPositionTheta );
+	camPos.z = cosf( m_cameraPositionTheta );
+	camPos *= m_cameraRadius;
+	return camPos + m_cameraFocusPoint;
+}
+
+/*
+====================================================
+Application::FireProjectile
+Throws a ball from the camera at the focus point, the physics thread adds it before its next tick
+====================================================
+*/
+void Application::FireProjectile() {
+	const Vec3 origin = GetCameraPosition();
+	Vec3 dir = m_cameraFocusPoint - origin;
+	dir.Normalize();
+
+	Body projectile;
+	projectile.position = origin;
+	projectile.orientation = Quat( 0, 0, 0, 1 );
+	projectile.shape = scene->shapes.AddSphere( 0.25f );
+	projectile.inverseMass = 1.0f;
+	projectile.elasticity = 0.5f;
+	projectile.friction = 0.5f;
+	projectile.linearVelocity = dir * 30.0f;
+	m_physicsThread.RequestSpawn( &projectile, 1 );
+}
+
+/*
+====================================================
+Application::ClearProjectiles
+Despawns the bodies with the projectile shape, by the handles of the latest snapshot
+====================================================
+*/
+void Application::ClearProjectiles() {
+	const int projectileShape = scene->shapes.GetIndex( scene->shapes.AddSphere( 0.25f ) );
+	const TransformSnapshot & snapshot = m_physicsThread.AcquireSnapshot();
+
+	std::vector< BodyHandle > projectiles;
+	for ( int i = 0; i < snapshot.handles.size(); i++ ) {
+		if ( snapshot.shapeIndices[ i ] == projectileShape ) {
+			projectiles.push_back( snapshot.handles[ i ] );
+		}
 	}
+	m_physicsThread.RequestDespawn( projectiles.data(), (int)projectiles.size() );
 }
 
 /*
@@ -456,8 +517,8 @@ void Application::MainLoop() {
 		if ( dt_us < 16000.0f ) {
 			int x = 16000 - (int)dt_us;
 			std::this_thread::sleep_for( std::chrono::microseconds( x ) );
-			dt_us = 16000;
 			time = GetTimeMicroseconds();
+			dt_us = (float)time - (float)timeLastFrame;
 		}
 		timeLastFrame = time;
 		printf( "\ndt_ms: %.1f    ", dt_us * 0.001f );
@@ -465,36 +526,12 @@ void Application::MainLoop() {
 		// Get User Input
 		glfwPollEvents();
 
-		// If the time is greater than 33ms (30fps)
-		// then force the time difference to smaller
-		// to prevent super large simulation steps.
-		if ( dt_us > 33000.0f ) {
-			dt_us = 33000.0f;
-		}
-
-		bool runPhysics = true;
+		// Physics runs on its own thread, only report how long its last ticks took
 		if ( m_isPaused ) {
-			dt_us = 0.0f;
-			runPhysics = false;
-			if ( m_stepFrame ) {
-				dt_us = 16667.0f;
-				m_stepFrame = false;
-				runPhysics = true;
-			}
 			numSamples = 0;
 			maxTime = 0.0f;
-		}
-		float dt_sec = dt_us * 0.001f * 0.001f;
-
-		// Run Update
-		if ( runPhysics ) {
-			int startTime = GetTimeMicroseconds();
-			for ( int i = 0; i < 2; i++ ) {
-				scene->Update( dt_sec * 0.5f );
-			}
-			int endTime = GetTimeMicroseconds();
-
-			dt_us = (float)endTime - (float)startTime;
+		} else {
+			dt_us = (float)m_physicsThread.GetUpdateMicroseconds();
 			if ( dt_us > maxTime ) {
 				maxTime = dt_us;
 			}
@@ -510,12 +547,30 @@ void Application::MainLoop() {
 	}
 }
 
+/*
+====================================================
+Application::UpdateModels
+Builds the models of the shapes added to the library since the last call, bodies spawned with them can then be drawn
+====================================================
+*/
+void Application::UpdateModels() {
+	const int numShapes = scene->shapes.GetNumShapes();
+	for ( int i = (int)m_models.size(); i < numShapes; i++ ) {
+		Model * model = new Model();
+		model->BuildFromShape( scene->shapes.GetShape( i ) );
+		model->MakeVBO( &deviceContext );
+
+		m_models.push_back( model );
+	}
+}
+
 /*
 ====================================================
 Application::UpdateUniforms
 ====================================================
 */
 void Application::UpdateUniforms() {
+	UpdateModels();
 	m_renderModels.clear();
 
 	uint32_t uboByteOffset = 0;
@@ -540,19 +595,10 @@ void Application::UpdateUniforms() {
 		// Update the uniform buffer with the camera information
 		//
 		{
-			Vec3 camPos = Vec3( 10, 0, 5 ) * 1.25f;
-			Vec3 camLookAt = Vec3( 0, 0, 1 );
+			Vec3 camPos = GetCameraPosition();
+			Vec3 camLookAt = m_cameraFocusPoint;
 			Vec3 camUp = Vec3( 0, 0, 1 );
 
-			camPos.x = cosf( m_cameraPositionPhi ) * sinf( m_cameraPositionTheta );
-			camPos.y = sinf( m_cameraPositionPhi ) * sinf( m_cameraPositionTheta );
-			camPos.z = cosf( m_cameraPositionTheta );
-			camPos *= m_cameraRadius;
-
-			camPos += m_cameraFocusPoint;
-
-			camLookAt = m_cameraFocusPoint;
-
 			int windowWidth;
 			int windowHeight;
 			glfwGetWindowSize( glfwWindow, &windowWidth, &windowHeight );
@@ -614,31 +660,51 @@ void Application::UpdateUniforms() {
 		}
 
 		//
-		//	Update the uniform buffer with the body positions/orientations
+		//	Update the uniform buffer with the body positions/orientations,
+		//	interpolated between the last two physics steps of the latest snapshot.
+		//	Every body has its own slot in the buffer, they are filled in parallel
 		//
-		for ( int i = 0; i < scene->bodies.size(); i++ ) {
-			Body & body = scene->bodies[ i ];
-
-			Vec3 fwd = body.orientation.RotatePoint( Vec3( 1, 0, 0 ) );
-			Vec3 up = body.orientation.RotatePoint( Vec3( 0, 0, 1 ) );
-
-			Mat4 matOrient;
-			matOrient.Orient( body.position, fwd, up );
-			matOrient = matOrient.Transpose();
-
-			// Update the uniform buffer with the orientation of this body
-			memcpy( mappedData + uboByteOffset, matOrient.ToPtr(), sizeof( matOrient ) );
-
-			RenderModel renderModel;
-			renderModel.model = m_models[ i ];
-			renderModel.uboByteOffset = uboByteOffset;
-			renderModel.uboByteSize = sizeof( matOrient );
-			renderModel.pos = body.position;
-			renderModel.orient = body.orientation;
-			m_renderModels.push_back( renderModel );
+		const TransformSnapshot & snapshot = m_physicsThread.AcquireSnapshot();
+		const float alpha = m_physicsThread.GetInterpolationAlpha( snapshot );
+		const int numBodies = ( (int)snapshot.positions.size() < MAX_DRAWN_BODIES ) ? (int)snapshot.positions.size() : MAX_DRAWN_BODIES;
+		const uint32_t bodiesByteOffset = uboByteOffset;
+		const uint32_t bodyByteSize = deviceContext.GetAligendUniformByteOffset( sizeof( Mat4 ) );
+		m_renderModels.resize( numBodies );
+		m_jobSystem.ParallelFor( numBodies, 64, [ & ]( const int begin, const int end ) {
+			for ( int i = begin; i < end; i++ ) {
+				const Vec3 position = snapshot.previousPositions[ i ] + ( snapshot.positions[ i ] - snapshot.previousPositions[ i ] ) * alpha;
+				const Quat orientation = Quat::Nlerp( snapshot.previousOrientations[ i ], snapshot.orientations[ i ], alpha );
+
+				Vec3 fwd = orientation.RotatePoint( Vec3( 1, 0, 0 ) );
+				Vec3 up = orientation.RotatePoint( Vec3( 0, 0, 1 ) );
+
+				Mat4 matOrient;
+				matOrient.Orient( position, fwd, up );
+				matOrient = matOrient.Transpose();
+
+				// Update the uniform buffer with the orientation of this body
+				const uint32_t byteOffset = bodiesByteOffset + bodyByteSize * i;
+				memcpy( mappedData + byteOffset, matOrient.ToPtr(), sizeof( matOrient ) );
+
+				// A shape from outside the library has no model, the body is not drawn
+				const int shapeIndex = snapshot.shapeIndices[ i ];
+				RenderModel & renderModel = m_renderModels[ i ];
+				renderModel.model = ( shapeIndex >= 0 && shapeIndex < (int)m_models.size() ) ? m_models[ shapeIndex ] : NULL;
+				renderModel.uboByteOffset = byteOffset;
+				renderModel.uboByteSize = sizeof( matOrient );
+				renderModel.pos = position;
+				renderModel.orient = orientation;
+			}
+		} );
+		uboByteOffset += bodyByteSize * (uint32_t)numBodies;
 
-			uboByteOffset += deviceContext.GetAligendUniformByteOffset( sizeof( matOrient ) );
+		int numDrawn = 0;
+		for ( int i = 0; i < numBodies; i++ ) {
+			if ( NULL != m_renderModels[ i ].model ) {
+				m_renderModels[ numDrawn++ ] = m_renderModels[ i ];
+			}
 		}
+		m_renderModels.resize( numDrawn );
 
 		m_uniformBuffer.UnmapBuffer( &deviceContext );
 	}
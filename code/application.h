@@ -18,6 +18,8 @@
 #include "Renderer/model.h"
 #include "Renderer/shader.h"
 #include "Renderer/FrameBuffer.h"
+#include "Threading/JobSystem.h"
+#include "PhysicsThread.h"
 
 /*
 ====================================================
@@ -26,7 +28,7 @@ Application
 */
 class Application {
 public:
-	Application() : m_isPaused( true ), m_stepFrame( false ) {}
+	Application() : m_isPaused( true ), m_jobSystem( (int)std::thread::hardware_concurrency() / 4 ) {}
 	~Application();
 
 	void Initialize();
@@ -38,12 +40,16 @@ private:
 	void InitializeGLFW();
 	bool InitializeVulkan();
 	void Cleanup();
+	void UpdateModels();
 	void UpdateUniforms();
 	void DrawFrame();
 	void ResizeWindow( int windowWidth, int windowHeight );
 	void MouseMoved( float x, float y );
 	void MouseScrolled( float z );
 	void Keyboard( int key, int scancode, int action, int modifiers );
+	Vec3 GetCameraPosition() const;
+	void FireProjectile();
+	void ClearProjectiles();
 
 	static void OnWindowResized( GLFWwindow * window, int width, int height );
 	static void OnMouseMoved( GLFWwindow * window, double x, double y );
@@ -62,11 +68,14 @@ private:
 	//
 	Buffer m_uniformBuffer;
 
+	// Every drawn body takes a descriptor set of the pipelines and a matrix in the uniform buffer, the others are not drawn
+	static const int MAX_DRAWN_BODIES = Descriptors::MAX_DESCRIPTOR_SETS;
+
 	//
 	//	Model
 	//
 	Model m_modelFullScreen;
-	std::vector< Model * > m_models;	// models for the bodies
+	std::vector< Model * > m_models;	// One per shape of the scene's library, in the same order
 
 	//
 	//	Pipeline for copying the offscreen framebuffer to the swapchain
@@ -82,7 +91,12 @@ private:
 	float m_cameraPositionPhi;
 	float m_cameraRadius;
 	bool m_isPaused;
-	bool m_stepFrame;
+
+	// Per frame work of the renderer, the scene steps on the job system of the physics thread
+	JobSystem m_jobSystem;
+
+	// Steps the scene at a fixed rate, the frames draw its latest snapshot
+	PhysicsThread m_physicsThread;
 
 	std::vector< RenderModel > m_renderModels;
 